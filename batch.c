@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "tas.h"
+#include "prep.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#define BATCH_THREADS
+#endif
+
+// Runs one program against every input set in a file, one set per line, on several threads
+// A line is the values " tiles read in order, or arguments for ' tiles then | then the values for " tiles i.e. 3 4 | 10
+// The program is loaded once and shared by every thread, each thread has its own instance to run it with
+// The output of each line is written in the order of the file, as soon as every line before it is done
+
+// The output of one line, kept until every line before it has been written
+typedef struct OutputBufferStruct {
+    char * text;
+    size_t length;
+    size_t capacity;
+} outputBuffer;
+
+// One line of the input file
+typedef struct BatchJobStruct {
+    char * line; // Points into the input file, not NUL terminated
+    size_t lineLength;
+    outputBuffer output;
+    bool done;
+} batchJob;
+
+// The jobs a worker still has to run, from next up to but not including end
+// Other workers steal from the end so the owner and the thief rarely want the same jobs
+typedef struct JobRangeStruct {
+    unsigned int next;
+    unsigned int end;
+#ifdef BATCH_THREADS
+    pthread_mutex_t lock;
+#endif
+} jobRange;
+
+typedef struct BatchStruct {
+    tasProgram * program; // Shared by every worker, never changed while running
+    tasOptions options;
+    batchJob * jobs;
+    unsigned int jobCount;
+    jobRange * ranges; // One for each worker
+    unsigned int workerCount;
+
+    unsigned int written; // How many jobs have had their output written, in order
+    unsigned int failed; // How many jobs stopped with an error
+#ifdef BATCH_THREADS
+    pthread_mutex_t outputLock;
+#endif
+} batch;
+
+// The thread a worker runs on needs to know which one it is
+typedef struct WorkerStruct {
+    batch * work;
+    unsigned int index;
+} worker;
+
+#ifdef BATCH_THREADS
+#define LOCK(mutex) pthread_mutex_lock(mutex)
+#define UNLOCK(mutex) pthread_mutex_unlock(mutex)
+#else
+#define LOCK(mutex)
+#define UNLOCK(mutex)
+#endif
+
+// Adds output to the end of a buffer, growing it when needed
+void writeBuffer(void * context, const char * text, size_t length){
+    outputBuffer * output = (outputBuffer *)context;
+    if (output->length + length > output->capacity){
+        size_t capacity = output->capacity == 0 ? 256 : output->capacity;
+        while (output->length + length > capacity){
+            capacity *= 2;
+        }
+        output->text = realloc(output->text, capacity);
+        output->capacity = capacity;
+    }
+    memcpy(output->text + output->length, text, length);
+    output->length += length;
+}
+
+// Reads the integers of part of a line into values, which needs room for length / 2 + 1 of them
+// Returns how many there were, or -1 if something that isn't an integer is found, with bad set to where it starts
+int parseValues(const char * text, size_t length, int * values, const char ** bad){
+    int count = 0;
+    size_t i = 0;
+    while (i < length){
+        if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r'){
+            i++;
+            continue;
+        }
+
+        // Parsing in place since the line isn't NUL terminated, so a token of any length is read whole
+        size_t start = i;
+        bool negative = text[i] == '-';
+        if (text[i] == '-' || text[i] == '+'){
+            i++;
+        }
+        // Building the magnitude as unsigned so INT_MIN can be read, anything past it is out of range
+        unsigned int limit = negative ? (unsigned int)INT_MAX + 1 : (unsigned int)INT_MAX;
+        unsigned int magnitude = 0;
+        bool valid = i < length && text[i] >= '0' && text[i] <= '9';
+        while (i < length && text[i] >= '0' && text[i] <= '9'){
+            unsigned int digit = (unsigned int)(text[i] - '0');
+            if (magnitude > (limit - digit) / 10){
+                valid = false;
+            } else {
+                magnitude = magnitude * 10 + digit;
+            }
+            i++;
+        }
+        if (i < length && text[i] != ' ' && text[i] != '\t' && text[i] != '\r'){
+            valid = false;
+        }
+        if (!valid){
+            *bad = text + start;
+            return -1;
+        }
+        int value = negative ? (int)(0u - magnitude) : (int)magnitude;
+        values[count] = value;
+        count++;
+    }
+    return count;
+}
+
+// Writes an error for a line into its output
+void writeJobError(batchJob * job, unsigned int lineNumber, const char * message){
+    char text [strlen(message) + 32];
+    int length = sprintf(text, "Error on line %u: %s\n", lineNumber, message);
+    writeBuffer(&job->output, text, (size_t)length);
+}
+
+// Runs the program with one line's values, returning whether it ran without an error
+bool runJob(tasInstance * instance, batchJob * job, unsigned int lineNumber){
+    int * values = malloc(sizeof(int) * (job->lineLength / 2 + 1)); // Numbers are always followed by a space or the end
+    const char * bad;
+
+    // Everything before a | is arguments for ' tiles, the rest is input for " tiles
+    const char * bar = memchr(job->line, '|', job->lineLength);
+    int argumentCount = 0;
+    const char * inputStart = job->line;
+    if (bar != NULL){
+        argumentCount = parseValues(job->line, (size_t)(bar - job->line), values, &bad);
+        inputStart = bar + 1;
+    }
+    int inputCount = argumentCount == -1 ? -1 : parseValues(inputStart, job->lineLength - (size_t)(inputStart - job->line),
+                                                            values + argumentCount, &bad);
+    if (inputCount == -1){
+        const char * end = bad;
+        while (end < job->line + job->lineLength && *end != ' ' && *end != '\t' && *end != '\r'){
+            end++;
+        }
+        char message [(end - bad) + 32];
+        sprintf(message, "\"%.*s\" is not an integer", (int)(end - bad), bad);
+        writeJobError(job, lineNumber, message);
+        free(values);
+        return false;
+    }
+
+    tasSetInputValues(instance, values + argumentCount, (size_t)inputCount);
+    tasSetOutput(instance, writeBuffer, &job->output);
+    bool ran = tasRun(instance, values, (unsigned int)argumentCount, NULL, 0, NULL) == TAS_OK;
+    if (!ran){
+        writeJobError(job, lineNumber, tasErrorMessage(instance));
+    }
+    free(values);
+    return ran;
+}
+
+// Takes the next job of a worker's own range, or steals the back half of another worker's
+// Returns false once every range is empty
+bool takeJob(batch * work, unsigned int self, unsigned int * job){
+    jobRange * own = &work->ranges[self];
+    LOCK(&own->lock);
+    if (own->next < own->end){
+        *job = own->next;
+        own->next++;
+        UNLOCK(&own->lock);
+        return true;
+    }
+    UNLOCK(&own->lock);
+
+    for (unsigned int i = 1; i < work->workerCount; i++){
+        jobRange * victim = &work->ranges[(self + i) % work->workerCount];
+        LOCK(&victim->lock);
+        unsigned int left = victim->end - victim->next;
+        if (left == 0){
+            UNLOCK(&victim->lock);
+            continue;
+        }
+
+        // Taking the back half, or the last job, and running the first of it straight away
+        unsigned int taken = left > 1 ? left / 2 : 1;
+        unsigned int start = victim->end - taken;
+        unsigned int end = victim->end;
+        victim->end = start;
+        UNLOCK(&victim->lock);
+
+        LOCK(&own->lock);
+        own->next = start + 1;
+        own->end = end;
+        UNLOCK(&own->lock);
+        *job = start;
+        return true;
+    }
+    return false;
+}
+
+// Marks a job as done and writes the output of every finished job that is next in order
+void finishJob(batch * work, unsigned int job, bool ran){
+    LOCK(&work->outputLock);
+    work->jobs[job].done = true;
+    if (!ran){
+        work->failed++;
+    }
+    while (work->written < work->jobCount && work->jobs[work->written].done){
+        outputBuffer * output = &work->jobs[work->written].output;
+        fwrite(output->text, 1, output->length, stdout);
+        free(output->text);
+        output->text = NULL;
+        work->written++;
+    }
+    UNLOCK(&work->outputLock);
+}
+
+// Runs jobs until there are none left anywhere
+void * runWorker(void * argument){
+    worker * self = (worker *)argument;
+    batch * work = self->work;
+    tasInstance * instance = tasCreateInstance(work->program, &work->options);
+    unsigned int job;
+    while (takeJob(work, self->index, &job)){
+        bool ran = runJob(instance, &work->jobs[job], job + 1);
+        finishJob(work, job, ran);
+    }
+    tasFreeInstance(instance);
+    return NULL;
+}
+
+// Runs every job using workerCount threads, the calling thread being one of them
+void runBatch(batch * work){
+    worker workers [work->workerCount];
+    for (unsigned int i = 0; i < work->workerCount; i++){
+        // Each worker starts with an even share of the lines in a row
+        work->ranges[i].next = (unsigned int)((unsigned long long)work->jobCount * i / work->workerCount);
+        work->ranges[i].end = (unsigned int)((unsigned long long)work->jobCount * (i + 1) / work->workerCount);
+#ifdef BATCH_THREADS
+        pthread_mutex_init(&work->ranges[i].lock, NULL);
+#endif
+        workers[i].work = work;
+        workers[i].index = i;
+    }
+
+#ifdef BATCH_THREADS
+    pthread_mutex_init(&work->outputLock, NULL);
+    pthread_t threads [work->workerCount];
+    bool started [work->workerCount];
+    for (unsigned int i = 1; i < work->workerCount; i++){
+        started[i] = pthread_create(&threads[i], NULL, runWorker, &workers[i]) == 0;
+    }
+    runWorker(&workers[0]);
+    for (unsigned int i = 1; i < work->workerCount; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        }
+    }
+    // A worker that couldn't be started leaves its jobs to be stolen, so they have all run by now
+    for (unsigned int i = 0; i < work->workerCount; i++){
+        pthread_mutex_destroy(&work->ranges[i].lock);
+    }
+    pthread_mutex_destroy(&work->outputLock);
+#else
+    runWorker(&workers[0]);
+#endif
+}
+
+// Splits the input file into lines, dropping a last line that is empty
+batchJob * splitLines(char * text, size_t length, unsigned int * count){
+    unsigned int capacity = 64;
+    batchJob * jobs = malloc(sizeof(batchJob) * capacity);
+    *count = 0;
+    size_t start = 0;
+    while (start < length){
+        char * newline = memchr(text + start, '\n', length - start);
+        size_t end = newline != NULL ? (size_t)(newline - text) : length;
+        if (*count == capacity){
+            capacity *= 2;
+            jobs = realloc(jobs, sizeof(batchJob) * capacity);
+        }
+        jobs[*count].line = text + start;
+        jobs[*count].lineLength = end - start;
+        jobs[*count].output = (outputBuffer){NULL, 0, 0};
+        jobs[*count].done = false;
+        (*count)++;
+        start = end + 1;
+    }
+    return jobs;
+}
+
+int main(int argc, char* argv[]){
+    char * programName = NULL;
+    char * inputName = NULL;
+    int threadCount = 0;
+    tasOptions options;
+    tasDefaultOptions(&options);
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            // How many lines to run at once, by default one for each core
+            i++;
+            threadCount = atoi(argv[i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+            // The memory budget for function calls of each line in megabytes
+            i++;
+            options.memoryBudget = (size_t)strtoull(argv[i], NULL, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            // The most cycles each line may run for, so one that never finishes doesn't hold up the rest
+            i++;
+            options.cycleBudget = strtoull(argv[i], NULL, 10);
+        } else if (strcmp(argv[i], "-i") == 0){
+            options.useIntrinsics = false;
+        } else if (strcmp(argv[i], "-l") == 0){
+            options.accelerateLoops = false;
+        } else if (strcmp(argv[i], "-c") == 0){
+            options.memoise = false;
+        } else if (strcmp(argv[i], "-p") == 0){
+            options.runLeaves = false;
+        } else if (programName == NULL){
+            programName = argv[i];
+        } else {
+            inputName = argv[i];
+        }
+    }
+    if (programName == NULL || inputName == NULL){
+        puts("Need a program and a file of input sets - tasbatch program.ptas inputs.txt [-j threads]");
+        return 1;
+    }
+
+    int result;
+    tasProgram * program = tasLoadProgram(programName, &result);
+    if (program == NULL){
+        if (result == TAS_ERROR_FILE){
+            printf("Error: Could not open file \"%s\"\n", programName);
+        } else {
+            printf("Error: %s, or a file it calls, has remote activators that could not be linked\n", programName);
+        }
+        return 1;
+    }
+
+    FILE * inputFile = fopen(inputName, "rb");
+    size_t length;
+    char * text = tasReadSource(inputFile, &length);
+    if (inputFile != NULL){
+        fclose(inputFile);
+    }
+    if (text == NULL){
+        printf("Error: Could not open file \"%s\"\n", inputName);
+        tasFreeProgram(program);
+        return 1;
+    }
+
+    batch work;
+    work.program = program;
+    work.options = options;
+    work.jobs = splitLines(text, length, &work.jobCount);
+    work.written = 0;
+    work.failed = 0;
+#ifdef BATCH_THREADS
+    if (threadCount <= 0){
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cores > 0 ? (int)cores : 1;
+    }
+#else
+    threadCount = 1;
+#endif
+    work.workerCount = work.jobCount == 0 ? 1 : ((unsigned int)threadCount < work.jobCount ? (unsigned int)threadCount : work.jobCount);
+    work.ranges = malloc(sizeof(jobRange) * work.workerCount);
+    runBatch(&work);
+
+    free(work.ranges);
+    free(work.jobs);
+    free(text);
+    tasFreeProgram(program);
+    return work.failed > 0 ? 1 : 0;
+}
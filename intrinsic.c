@@ -0,0 +1,79 @@
+#include <string.h>
+#include "intrinsic.h"
+
+// Reads a parameter the way ' does, using 0 when the arguments have run out
+// The message ' prints for each missing one is printed by whoever runs the intrinsic
+static int intrinsicParameter(int * arguments, unsigned int argumentCount, unsigned int index){
+    if (index < argumentCount){
+        return arguments[index];
+    }
+    return 0;
+}
+
+// What stdmult works out, the first value added to itself while the second counts down to 1
+// The count starts one below the second value and wraps the same way - does, so it is worked out unsigned
+static int multiplyLikeTAS(int value, int count){
+    int remaining = (int)((unsigned int)count - 1u);
+    if (remaining <= 0){
+        return value;
+    }
+    return (int)((unsigned int)value * ((unsigned int)remaining + 1u));
+}
+
+// .>'val1 'val2 *val1 =sum *val2 ^sum
+static void runStdAdd(int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount){
+    int first = intrinsicParameter(arguments, argumentCount, 0);
+    int second = intrinsicParameter(arguments, argumentCount, 1);
+    if (returnCount > 0){
+        returns[0] = (int)((unsigned int)first + (unsigned int)second);
+    }
+}
+
+// Adds val1 to itself val2 - 1 times, giving val1 unchanged when val2 is below 2
+static void runStdMult(int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount){
+    int value = intrinsicParameter(arguments, argumentCount, 0);
+    int count = intrinsicParameter(arguments, argumentCount, 1);
+    if (returnCount > 0){
+        returns[0] = multiplyLikeTAS(value, count);
+    }
+}
+
+// Calls stdmult val2 - 1 times with val1 and the running value
+static void runStdPow(int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount){
+    int base = intrinsicParameter(arguments, argumentCount, 0);
+    int remaining = (int)((unsigned int)intrinsicParameter(arguments, argumentCount, 1) - 1u);
+
+    int value = base;
+    for (int i = 1; i <= remaining; i++){
+        value = multiplyLikeTAS(base, value);
+
+        // Once the value is back to where it started it repeats, so the whole repeats left can be skipped
+        if (value == base){
+            int left = (remaining - i) % i;
+            for (int j = 0; j < left; j++){
+                value = multiplyLikeTAS(base, value);
+            }
+            break;
+        }
+    }
+
+    if (returnCount > 0){
+        returns[0] = value;
+    }
+}
+
+// Every intrinsic, new ones just need adding here
+static const Intrinsic intrinsics [] = {
+    {"stdadd.ptas", runStdAdd, 2},
+    {"stdmult.ptas", runStdMult, 2},
+    {"stdpow.ptas", runStdPow, 2},
+};
+
+const Intrinsic * tasFindIntrinsic(const char * name){
+    for (unsigned int i = 0; i < sizeof(intrinsics) / sizeof(Intrinsic); i++){
+        if (strcmp(intrinsics[i].name, name) == 0){
+            return &intrinsics[i];
+        }
+    }
+    return NULL;
+}
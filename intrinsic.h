@@ -0,0 +1,18 @@
+
+#ifndef TAS_INTRINSIC_H
+#define TAS_INTRINSIC_H
+
+// Native versions of stdlib functions, used for & calls in place of running their .ptas files
+// Each one gives exactly the return values the TAS version does, including how it wraps on overflow
+typedef struct IntrinsicStruct {
+    const char * name; // The file name calls use i.e. stdadd.ptas
+    // Works out the return values from the arguments, both with the one nearest the & first
+    // returns starts as all 0, the same as return holders the TAS version never sets
+    void (*run)(int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount);
+    unsigned int parameterCount; // How many parameters it reads, the caller prints a message for each missing one before running it
+} Intrinsic;
+
+// Returns the intrinsic for a called file name, or NULL if it has to be run as TAS
+const Intrinsic * tasFindIntrinsic(const char * name);
+
+#endif //TAS_INTRINSIC_H
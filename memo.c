@@ -0,0 +1,155 @@
+#include "memo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a hash of the module and the argument values
+static unsigned int memoHash(const void * module, int * arguments, unsigned int argumentCount, unsigned int returnCount){
+    unsigned int hash = 2166136261u;
+    unsigned long long address = (unsigned long long)(size_t)module;
+    unsigned int words [4] = {(unsigned int)address, (unsigned int)(address >> 32), argumentCount, returnCount};
+    for (unsigned int i = 0; i < 4 + argumentCount; i++){
+        unsigned int word = i < 4 ? words[i] : (unsigned int)arguments[i - 4];
+        for (unsigned int b = 0; b < 4; b++){
+            hash ^= (word >> (b * 8)) & 0xff;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Returns the entry for a call, or NULL if it isn't cached
+static memoEntry * findMemoEntry(memoCache * cache, unsigned int hash, const void * module, int * arguments, unsigned int argumentCount, unsigned int returnCount){
+    for (memoEntry * entry = cache->buckets[hash & (cache->bucketCount - 1)]; entry != NULL; entry = entry->chain){
+        if (entry->hash == hash && entry->module == module && entry->argumentCount == argumentCount
+            && entry->returnCount == returnCount && memcmp(entry->values, arguments, sizeof(int) * argumentCount) == 0){
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void unlinkMemoUse(memoCache * cache, memoEntry * entry){
+    if (entry->newer != NULL){
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL){
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+// Moves an entry to the front of the order of use
+static void markMemoUsed(memoCache * cache, memoEntry * entry){
+    entry->older = cache->newest;
+    entry->newer = NULL;
+    if (cache->newest != NULL){
+        cache->newest->newer = entry;
+    }
+    cache->newest = entry;
+    if (cache->oldest == NULL){
+        cache->oldest = entry;
+    }
+}
+
+// Takes an entry out of its bucket
+static void unlinkMemoBucket(memoCache * cache, memoEntry * entry){
+    memoEntry ** link = &cache->buckets[entry->hash & (cache->bucketCount - 1)];
+    while (*link != entry){
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+}
+
+memoCache * tasCreateMemoCache(unsigned int capacity){
+    memoCache * cache = malloc(sizeof(memoCache));
+    cache->capacity = capacity > 0 ? capacity : 1;
+    cache->entries = calloc(cache->capacity, sizeof(memoEntry));
+    cache->count = 0;
+    cache->bucketCount = 16;
+    while (cache->bucketCount < cache->capacity * 2){
+        cache->bucketCount *= 2;
+    }
+    cache->buckets = calloc(cache->bucketCount, sizeof(memoEntry *));
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    return cache;
+}
+
+bool tasFindMemo(memoCache * cache, const void * module, int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount){
+    unsigned int hash = memoHash(module, arguments, argumentCount, returnCount);
+    memoEntry * entry = findMemoEntry(cache, hash, module, arguments, argumentCount, returnCount);
+    if (entry == NULL){
+        cache->misses++;
+        return false;
+    }
+
+    cache->hits++;
+    unlinkMemoUse(cache, entry);
+    markMemoUsed(cache, entry);
+    memcpy(returns, entry->values + argumentCount, sizeof(int) * returnCount);
+    return true;
+}
+
+void tasStoreMemo(memoCache * cache, const void * module, int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount){
+    unsigned int hash = memoHash(module, arguments, argumentCount, returnCount);
+    if (findMemoEntry(cache, hash, module, arguments, argumentCount, returnCount) != NULL){
+        return; // A recursive call with the same arguments finished first
+    }
+
+    // Using a free entry, or else dropping the one used longest ago
+    memoEntry * entry;
+    if (cache->count < cache->capacity){
+        entry = &cache->entries[cache->count];
+        cache->count++;
+    } else {
+        entry = cache->oldest;
+        unlinkMemoUse(cache, entry);
+        unlinkMemoBucket(cache, entry);
+        cache->evictions++;
+    }
+
+    unsigned int valueCount = argumentCount + returnCount;
+    if (valueCount > entry->valueCapacity){
+        free(entry->values);
+        entry->valueCapacity = valueCount;
+        entry->values = malloc(sizeof(int) * valueCount);
+    }
+    entry->hash = hash;
+    entry->module = module;
+    entry->argumentCount = argumentCount;
+    entry->returnCount = returnCount;
+    memcpy(entry->values, arguments, sizeof(int) * argumentCount);
+    memcpy(entry->values + argumentCount, returns, sizeof(int) * returnCount);
+
+    unsigned int bucket = hash & (cache->bucketCount - 1);
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    markMemoUsed(cache, entry);
+}
+
+void tasShowMemoStats(memoCache * cache){
+    unsigned long long lookups = cache->hits + cache->misses;
+    printf("Pure calls: %llu hits, %llu misses (%.1f%% hit), %llu evicted, %u of %u cached\n",
+           cache->hits,
+           cache->misses,
+           lookups > 0 ? 100.0 * cache->hits / lookups : 0.0,
+           cache->evictions,
+           cache->count,
+           cache->capacity);
+}
+
+void tasFreeMemoCache(memoCache * cache){
+    for (unsigned int i = 0; i < cache->capacity; i++){
+        free(cache->entries[i].values);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
@@ -0,0 +1,52 @@
+
+#ifndef TAS_MEMO_H
+#define TAS_MEMO_H
+
+#include <stdbool.h>
+
+// The results of calls to pure modules, so a call with the same arguments as an earlier one can skip running
+// Keyed by the module, the argument values, and how many return holders the call has
+// Holds at most capacity calls, dropping the one used longest ago to make room
+
+#define DEFAULT_MEMO_CAPACITY 65536
+
+typedef struct MemoEntryStruct {
+    unsigned int hash;
+    const void * module;
+    unsigned int argumentCount;
+    unsigned int returnCount;
+    int * values; // The arguments followed by the return values
+    unsigned int valueCapacity; // How many values there is room for, kept when the entry is reused
+    struct MemoEntryStruct * chain; // The next entry in the same bucket
+    struct MemoEntryStruct * newer; // The entries in order of use, for finding the one to drop
+    struct MemoEntryStruct * older;
+} memoEntry;
+
+typedef struct MemoCacheStruct {
+    memoEntry * entries; // Every entry, allocated up front
+    unsigned int capacity;
+    unsigned int count; // How many entries are in use
+    memoEntry ** buckets;
+    unsigned int bucketCount; // Always a power of 2
+    memoEntry * newest;
+    memoEntry * oldest;
+
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+} memoCache;
+
+memoCache * tasCreateMemoCache(unsigned int capacity);
+
+// Looks for an earlier call with the same arguments, copying its return values into returns if there is one
+// Counts as a hit or a miss
+bool tasFindMemo(memoCache * cache, const void * module, int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount);
+
+// Remembers the return values of a call that has finished
+void tasStoreMemo(memoCache * cache, const void * module, int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount);
+
+void tasShowMemoStats(memoCache * cache);
+
+void tasFreeMemoCache(memoCache * cache);
+
+#endif //TAS_MEMO_H
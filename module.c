@@ -0,0 +1,1252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "module.h"
+#include "varmgr.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define TAS_MMAP
+#endif
+
+// Works out where the spans of every tile end in the given direction, the end itself is never part of the span
+// Activation spans stop before a blocker or just after a poker, deactivation spans only stop before a blocker
+// Done in one pass from the far end so each tile takes the end from its neighbour instead of walking its own span
+static void computeSpanEnds(Module * module, int direction, int * activationEnds, int * deactivationEnds){
+    int edge = direction == 1 ? (int)module->length : -1; // Spans with nothing to stop them run off this edge
+    int start = direction == 1 ? (int)module->length - 1 : 0; // The pass starts at the edge and moves against direction
+    int stop = direction == 1 ? -1 : (int)module->length;
+    int activationEnd = edge;
+    int deactivationEnd = edge;
+
+    for (int i = start; i != stop; i -= direction){
+        activationEnds[i] = activationEnd;
+        deactivationEnds[i] = deactivationEnd;
+
+        char type = module->types[i];
+        if (type == '_'){
+            activationEnd = i;
+            deactivationEnd = i;
+        } else if (type == '}' || type == '{'){
+            activationEnd = i + direction;
+        }
+    }
+}
+
+// Works out where the spans of each tile end, using the deactivation ends for ( and ) and the activation ends for everything else
+static void resolveSpans(Module * module){
+    unsigned int spanCount = module->length > 0 ? module->length : 1;
+    int * rightDeactivationEnds = malloc(sizeof(int) * spanCount);
+    int * leftDeactivationEnds = malloc(sizeof(int) * spanCount);
+    computeSpanEnds(module, 1, module->rightEnds, rightDeactivationEnds);
+    computeSpanEnds(module, -1, module->leftEnds, leftDeactivationEnds);
+
+    for (unsigned int i = 0; i < module->length; i++){
+        if (module->types[i] == ')'){
+            module->rightEnds[i] = rightDeactivationEnds[i];
+        } else if (module->types[i] == '('){
+            module->leftEnds[i] = leftDeactivationEnds[i];
+        }
+    }
+
+    free(rightDeactivationEnds);
+    free(leftDeactivationEnds);
+}
+
+// Returns the point of a tile
+Point * tasTilePoint(Module * module, unsigned int index){
+    return &module->points[module->names[index]];
+}
+
+// Works out the value a neighbouring tile gives to a ? or = tile
+// References (*) give the value of their variable, a run of units (|) gives how many units there are when counting units,
+// anything else or being off the edge gives 0
+static Operand makeOperand(Module * module, int index, int direction, bool countUnits){
+    Operand operand;
+    operand.kind = OPERAND_CONSTANT;
+    operand.value = 0;
+    operand.point = NULL;
+
+    if (index < 0 || index >= (int)module->length){
+        return operand;
+    }
+
+    Point * point = tasTilePoint(module, index);
+    if (module->types[index] == '*'){
+        if (point->slot != -1){
+            operand.kind = OPERAND_SLOT;
+            operand.value = point->slot;
+        } else {
+            operand.kind = OPERAND_POINT;
+            operand.point = point;
+        }
+    } else if (module->types[index] == '|' && countUnits){
+        // Counting the consecutive units going away from the tile
+        while (index >= 0 && index < (int)module->length && module->types[index] == '|'){
+            operand.value++;
+            index += direction;
+        }
+    }
+    return operand;
+}
+
+
+// Collects the consecutive references (*) going away from a function call for its arguments or return holders
+static Point ** collectReferences(Module * module, int index, int direction, unsigned int * count){
+    *count = 0;
+    for (int i = index; i >= 0 && i < (int)module->length && module->types[i] == '*'; i += direction){
+        (*count)++;
+    }
+    Point ** points = malloc(sizeof(Point *) * (*count > 0 ? *count : 1));
+    for (unsigned int i = 0; i < *count; i++){
+        points[i] = tasTilePoint(module, index + (int)i * direction);
+    }
+    return points;
+}
+
+// Returns where a slot is in a loop's variables, adding it if it isn't there yet
+static unsigned int loopVariable(unsigned int * slots, unsigned int * slotCount, int slot){
+    for (unsigned int i = 0; i < *slotCount; i++){
+        if (slots[i] == (unsigned int)slot){
+            return i;
+        }
+    }
+    slots[*slotCount] = (unsigned int)slot;
+    (*slotCount)++;
+    return *slotCount - 1;
+}
+
+// Writes the affine expression for an operand into row, where rows holds the current expression of every variable
+static void operandExpression(Operand * operand, unsigned int * slots, unsigned int slotCount, unsigned int * rows, unsigned int * row){
+    unsigned int width = slotCount + 1;
+    if (operand->kind == OPERAND_SLOT){
+        unsigned int variable = loopVariable(slots, &slotCount, operand->value);
+        memcpy(row, rows + variable * width, sizeof(unsigned int) * width);
+    } else {
+        memset(row, 0, sizeof(unsigned int) * width);
+        row[slotCount] = (unsigned int)operand->value;
+    }
+}
+
+// Returns whether a variable's expression is itself plus a constant, giving the constant
+static bool isSteppingRow(unsigned int * row, unsigned int variable, unsigned int slotCount, int * step){
+    for (unsigned int c = 0; c < slotCount; c++){
+        if (row[c] != (c == variable ? 1u : 0u)){
+            return false;
+        }
+    }
+    *step = (int)row[slotCount];
+    return true;
+}
+
+// Checks whether the ? at index makes a loop that can be run natively, returning NULL if it doesn't
+// The span to the right must only hold tiles that do nothing, or = + - on variables without joiners,
+// and end with a , that activates the ? again
+static Loop * findLoop(Module * module, int index){
+    Instruction * compare = &module->code[index];
+    int last = compare->rightEnd - 1;
+    if (last <= index || module->code[last].op != OP_REMOTE || module->code[last].target != index
+        || compare->left.kind == OPERAND_POINT || compare->right.kind == OPERAND_POINT){
+        return NULL;
+    }
+
+    unsigned int stepCount = 0;
+    for (int i = index + 1; i < last; i++){
+        Instruction * instruction = &module->code[i];
+        if (instruction->op == OP_NOP){
+            continue;
+        }
+        if ((instruction->op != OP_ASSIGN && instruction->op != OP_INCREMENT && instruction->op != OP_DECREMENT)
+            || instruction->point->slot == -1
+            || instruction->left.kind == OPERAND_POINT || instruction->right.kind == OPERAND_POINT){
+            return NULL;
+        }
+        stepCount++;
+    }
+
+    Loop * loop = malloc(sizeof(Loop));
+    loop->steps = malloc(sizeof(LoopStep) * (stepCount > 0 ? stepCount : 1));
+    loop->stepCount = 0;
+    loop->tileCount = (unsigned int)(last - index);
+
+    // Gathering the variables, each step uses at most three and the ? two
+    unsigned int maxSlots = stepCount * 3 + 2;
+    loop->slots = malloc(sizeof(unsigned int) * maxSlots);
+    loop->slotCount = 0;
+    for (int i = index + 1; i < last; i++){
+        Instruction * instruction = &module->code[i];
+        if (instruction->op == OP_NOP){
+            continue;
+        }
+        LoopStep * step = &loop->steps[loop->stepCount];
+        step->op = instruction->op;
+        step->slot = instruction->point->slot;
+        step->left = instruction->left;
+        step->right = instruction->right;
+        loop->stepCount++;
+
+        loopVariable(loop->slots, &loop->slotCount, step->slot);
+        if (step->op == OP_ASSIGN){
+            if (step->left.kind == OPERAND_SLOT){
+                loopVariable(loop->slots, &loop->slotCount, step->left.value);
+            }
+            if (step->right.kind == OPERAND_SLOT){
+                loopVariable(loop->slots, &loop->slotCount, step->right.value);
+            }
+        }
+    }
+    if (compare->left.kind == OPERAND_SLOT){
+        loopVariable(loop->slots, &loop->slotCount, compare->left.value);
+    }
+    if (compare->right.kind == OPERAND_SLOT){
+        loopVariable(loop->slots, &loop->slotCount, compare->right.value);
+    }
+
+    loop->transform = NULL;
+    loop->counter = -1;
+    loop->step = 0;
+    loop->counterOnRight = false;
+    if (loop->slotCount > MAX_LOOP_VARIABLES){
+        return loop;
+    }
+
+    // Working out the map one iteration makes, starting with every variable as itself
+    unsigned int slotCount = loop->slotCount;
+    unsigned int width = slotCount + 1;
+    unsigned int * rows = calloc(width * width, sizeof(unsigned int));
+    for (unsigned int r = 0; r < width; r++){
+        rows[r * width + r] = 1;
+    }
+    unsigned int left [width];
+    unsigned int right [width];
+    for (unsigned int i = 0; i < loop->stepCount; i++){
+        LoopStep * step = &loop->steps[i];
+        unsigned int * row = rows + loopVariable(loop->slots, &slotCount, step->slot) * width;
+        if (step->op == OP_ASSIGN){
+            operandExpression(&step->left, loop->slots, slotCount, rows, left);
+            operandExpression(&step->right, loop->slots, slotCount, rows, right);
+            for (unsigned int c = 0; c < width; c++){
+                row[c] = left[c] + right[c];
+            }
+        } else {
+            row[slotCount] += step->op == OP_INCREMENT ? 1u : (unsigned int)-1;
+        }
+    }
+    loop->transform = rows;
+
+    // The iterations can be counted when one side of the ? stays the same and the other steps towards it
+    int step;
+    bool leftFixed = compare->left.kind == OPERAND_CONSTANT;
+    if (compare->left.kind == OPERAND_SLOT){
+        unsigned int variable = loopVariable(loop->slots, &slotCount, compare->left.value);
+        leftFixed = isSteppingRow(rows + variable * width, variable, slotCount, &step) && step == 0;
+    }
+    bool rightFixed = compare->right.kind == OPERAND_CONSTANT;
+    if (compare->right.kind == OPERAND_SLOT){
+        unsigned int variable = loopVariable(loop->slots, &slotCount, compare->right.value);
+        rightFixed = isSteppingRow(rows + variable * width, variable, slotCount, &step) && step == 0;
+    }
+    if (leftFixed && compare->right.kind == OPERAND_SLOT){
+        unsigned int counter = loopVariable(loop->slots, &slotCount, compare->right.value);
+        if (isSteppingRow(rows + counter * width, counter, slotCount, &step) && step < 0){
+            loop->counter = (int)counter;
+            loop->step = step;
+            loop->counterOnRight = true;
+        }
+    } else if (rightFixed && compare->left.kind == OPERAND_SLOT){
+        unsigned int counter = loopVariable(loop->slots, &slotCount, compare->left.value);
+        if (isSteppingRow(rows + counter * width, counter, slotCount, &step) && step > 0){
+            loop->counter = (int)counter;
+            loop->step = step;
+            loop->counterOnRight = false;
+        }
+    }
+    return loop;
+}
+
+// Whether an instruction only reads and writes variables without joiners, so it never touches the variable manager or arrays
+static bool usesOnlySlots(Instruction * instruction){
+    switch (instruction->op){
+        case OP_COMPARE:
+        case OP_ASSIGN:
+            if (instruction->left.kind == OPERAND_POINT || instruction->right.kind == OPERAND_POINT){
+                return false;
+            }
+            return instruction->op == OP_COMPARE || instruction->point->slot != -1;
+        case OP_INCREMENT:
+        case OP_DECREMENT:
+        case OP_INPUT:
+        case OP_PARAMETER:
+        case OP_DESTROY:
+        case OP_OUTPUT_INT:
+        case OP_RETURN:
+        case OP_OUTPUT_CHAR:
+            return instruction->point->slot != -1;
+        default:
+            return true;
+    }
+}
+
+// Lowers every tile into an instruction with its operands already worked out
+// This can only be done once the remote activators are linked, and the variable slots and spans are resolved
+static void compileModule(Module * module){
+    module->code = malloc(sizeof(Instruction) * (module->length > 0 ? module->length : 1));
+
+    for (int i = 0; i < (int)module->length; i++){
+        Point * point = tasTilePoint(module, i);
+        Instruction * instruction = &module->code[i];
+        memset(instruction, 0, sizeof(Instruction));
+        instruction->point = point;
+
+        switch (module->types[i]){
+            case '>':
+                instruction->op = OP_ACTIVATE_RIGHT;
+                instruction->rightEnd = module->rightEnds[i];
+                break;
+            case '<':
+                instruction->op = OP_ACTIVATE_LEFT;
+                instruction->leftEnd = module->leftEnds[i];
+                break;
+            case '}':
+            case '{':
+                // Pokes off the edge of the stack do nothing
+                instruction->target = module->types[i] == '}' ? i + 1 : i - 1;
+                instruction->op = (instruction->target < 0 || instruction->target >= (int)module->length) ? OP_NOP : OP_POKE;
+                break;
+            case '(':
+                instruction->op = OP_DEACTIVATE_LEFT;
+                instruction->leftEnd = module->leftEnds[i];
+                break;
+            case ')':
+                instruction->op = OP_DEACTIVATE_RIGHT;
+                instruction->rightEnd = module->rightEnds[i];
+                break;
+            case ',':
+                instruction->op = OP_REMOTE;
+                instruction->target = module->links[i];
+                break;
+            case '?':
+                instruction->op = OP_COMPARE;
+                instruction->left = makeOperand(module, i - 1, -1, true);
+                instruction->right = makeOperand(module, i + 1, 1, true);
+                instruction->rightEnd = module->rightEnds[i];
+                instruction->leftEnd = module->leftEnds[i];
+                break;
+            case '=':
+                instruction->op = OP_ASSIGN;
+                instruction->left = makeOperand(module, i - 1, -1, false);
+                instruction->right = makeOperand(module, i + 1, 1, false);
+                break;
+            case '+':
+                instruction->op = OP_INCREMENT;
+                break;
+            case '-':
+                instruction->op = OP_DECREMENT;
+                break;
+            case '\"':
+                instruction->op = OP_INPUT;
+                break;
+            case '\'':
+                instruction->op = OP_PARAMETER;
+                break;
+            case '~':
+                instruction->op = OP_DESTROY;
+                break;
+            case '&':
+                instruction->op = OP_CALL;
+                instruction->call = malloc(sizeof(Call));
+                instruction->call->module = NULL;
+                instruction->call->intrinsic = NULL;
+                // Creating the filename by add .ptas to the end of the name
+                instruction->call->fileName = malloc(strlen(point->name) + 6);
+                strcpy(instruction->call->fileName, point->name);
+                strcat(instruction->call->fileName, ".ptas");
+                // Variables on the left are used as arguments and variables on the right are used as return holders
+                instruction->call->arguments = collectReferences(module, i - 1, -1, &instruction->call->argumentCount);
+                instruction->call->returnHolders = collectReferences(module, i + 1, 1, &instruction->call->returnHolderCount);
+                break;
+            case '@':
+                instruction->op = OP_OUTPUT_INT;
+                break;
+            case '^':
+                instruction->op = OP_RETURN;
+                break;
+            case '$':
+                instruction->op = OP_OUTPUT_CHAR;
+                break;
+            case ';':
+                instruction->op = OP_NEWLINE;
+                break;
+            default:
+                instruction->op = OP_NOP;
+                break;
+        }
+    }
+
+    // Loops can only be found once every tile of their body has been lowered
+    // Any input or output tile makes the module impure, calls it makes can still print at runtime
+    module->pure = true;
+    module->leaf = module->length <= MAX_LEAF_TILES;
+    for (unsigned int i = 0; i < module->length; i++){
+        Instruction * instruction = &module->code[i];
+        unsigned char op = instruction->op;
+        if (op == OP_COMPARE){
+            instruction->loop = findLoop(module, i);
+        } else if (op == OP_INPUT || op == OP_OUTPUT_INT || op == OP_OUTPUT_CHAR || op == OP_NEWLINE){
+            module->pure = false;
+        } else if (op == OP_CALL){
+            module->leaf = false;
+        }
+        if (!usesOnlySlots(instruction)){
+            module->leaf = false;
+        }
+    }
+    module->leaf = module->leaf && module->pure;
+}
+
+static void freeCode(Module * module){
+    for (unsigned int i = 0; i < module->length; i++){
+        Loop * loop = module->code[i].loop;
+        if (loop != NULL){
+            free(loop->steps);
+            free(loop->slots);
+            free(loop->transform);
+            free(loop);
+        }
+
+        Call * call = module->code[i].call;
+        if (call != NULL){
+            free(call->fileName);
+            free(call->arguments);
+            free(call->returnHolders);
+            free(call);
+        }
+    }
+    free(module->code);
+}
+
+
+#define READ_BLOCK_SIZE (1 << 16)
+
+// Returns whether a character starts a new tile rather than being part of a name or a . initializer
+static bool isTileChar(char c){
+    return !isalnum((unsigned char)c) && c != ':' && c != '.';
+}
+
+// Reads a whole file into memory in large blocks, counting the tiles in each block as it arrives
+// The returned text is NUL terminated and must be freed by the caller, NULL if the file can't be opened
+static char * readProgram(const char * fileName, size_t * length, unsigned int * tileCount){
+	FILE * f = fopen(fileName, "rb");
+    // Checking if the file exists
+    if (f == NULL){
+        return NULL;
+    }
+
+    size_t capacity = READ_BLOCK_SIZE;
+    char * text = malloc(capacity + 1);
+    *length = 0;
+    *tileCount = 0;
+    size_t got;
+    while ((got = fread(text + *length, 1, capacity - *length, f)) > 0){
+        for (size_t i = *length; i < *length + got; i++){
+            if (isTileChar(text[i])){
+                (*tileCount)++;
+            }
+        }
+        *length += got;
+
+        if (*length == capacity){
+            capacity *= 2;
+            text = realloc(text, capacity + 1);
+        }
+    }
+	fclose(f);
+    text[*length] = '\0';
+    return text;
+}
+
+// Returns the position in sorted positions that is nearest to index, -1 if there are none
+// When one position on each side is just as near, the one to the right is used
+static int nearestPosition(unsigned int * positions, unsigned int count, unsigned int index){
+    // Binary searching for the first position after the index
+    unsigned int low = 0;
+    unsigned int high = count;
+    while (low < high){
+        unsigned int middle = low + (high - low) / 2;
+        if (positions[middle] <= index){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low == 0){
+        return count == 0 ? -1 : (int)positions[0];
+    }
+    if (low == count || index - positions[low - 1] < positions[low] - index){
+        return (int)positions[low - 1];
+    }
+    return (int)positions[low];
+}
+
+// Links each remote activator (,) to the nearest tile with the same point name that isn't a remote activator
+// The positions of each name's tiles are gathered into sorted lists so the nearest can be binary searched
+// Returns false if any of them has no tile to link to, they are left linked to -1
+static bool linkRemoteActivators(Module * module){
+    // Counting the tiles of each name, starts[p] will be where the positions of point p begin
+    unsigned int * starts = calloc(module->pointCount + 1, sizeof(unsigned int));
+    unsigned int activatorCount = 0;
+    for (unsigned int i = 0; i < module->length; i++){
+        module->links[i] = -1;
+        if (module->types[i] == ','){
+            activatorCount++;
+        } else {
+            starts[module->names[i] + 1]++;
+        }
+    }
+    if (activatorCount == 0){
+        free(starts);
+        return true;
+    }
+    for (unsigned int p = 0; p < module->pointCount; p++){
+        starts[p + 1] += starts[p];
+    }
+
+    // Filling in the positions, going through the tiles in order keeps each list sorted
+    unsigned int * positions = malloc(sizeof(unsigned int) * (starts[module->pointCount] > 0 ? starts[module->pointCount] : 1));
+    unsigned int * filled = malloc(sizeof(unsigned int) * module->pointCount);
+    memcpy(filled, starts, sizeof(unsigned int) * module->pointCount);
+    for (unsigned int i = 0; i < module->length; i++){
+        if (module->types[i] != ','){
+            positions[filled[module->names[i]]] = i;
+            filled[module->names[i]]++;
+        }
+    }
+    free(filled);
+
+    // Linking the remote activators
+    bool linked = true;
+    for (unsigned int i = 0; i < module->length; i++){
+        if (module->types[i] == ','){
+            unsigned int name = module->names[i];
+            module->links[i] = nearestPosition(positions + starts[name], starts[name + 1] - starts[name], i);
+            if (module->links[i] == -1){
+                linked = false;
+            }
+        }
+    }
+    free(positions);
+    free(starts);
+    return linked;
+}
+// Returns the slot for a name, giving it the next free slot if it hasn't been seen yet
+// slotNames maps each name to its slot + 1 so that a missing name reads as 0
+static int getNameSlot(char * name, struct varmgr * slotNames, unsigned int * slotCount){
+    int slot = tasGetVar(name, slotNames) - 1;
+    if (slot == -1){
+        slot = (int)*slotCount;
+        (*slotCount)++;
+        tasSetVar(name, slot + 1, slotNames);
+    }
+    return slot;
+}
+
+// Gives every point name without a joiner (:) a dense slot index so it can be accessed by index while running
+// Names with joiners keep a slot of -1 and instead remember the slots of the names that are joined on
+static void resolveVariableSlots(Module * module){
+    struct varmgr * slotNames = tasCreateVarMgr();
+    struct varmgr * arrayNames = tasCreateVarMgr();
+    module->slotCount = 0;
+    module->arrayCount = 0;
+
+    for (unsigned int i = 0; i < module->pointCount; i++){
+        Point * point = &module->points[i];
+        char * joiner = strchr(point->name, ':');
+        point->joinSlots = NULL;
+        point->joinCount = 0;
+        point->array = -1;
+
+        if (joiner == NULL){
+            point->slot = getNameSlot(point->name, slotNames, &module->slotCount);
+            point->baseLength = strlen(point->name);
+            continue;
+        }
+
+        point->slot = -1;
+        point->baseLength = joiner - point->name;
+
+        // Counting the joiners so the slots can be allocated at once
+        for (char * c = joiner; *c != '\0'; c++){
+            if (*c == ':'){
+                point->joinCount++;
+            }
+        }
+        point->joinSlots = malloc(sizeof(int) * point->joinCount);
+
+        // Resolving the name after each joiner
+        char part [strlen(point->name) + 1];
+        unsigned int joinIndex = 0;
+        while (joiner != NULL){
+            char * next = strchr(joiner + 1, ':');
+            size_t partLength = next == NULL ? strlen(joiner + 1) : (size_t)(next - joiner - 1);
+            memcpy(part, joiner + 1, partLength);
+            part[partLength] = '\0';
+
+            // An empty name after a joiner always reads as 0
+            point->joinSlots[joinIndex] = partLength == 0 ? -1 : getNameSlot(part, slotNames, &module->slotCount);
+            joinIndex++;
+            joiner = next;
+        }
+
+        // Names with one joiner are kept in a dense array for the name before the joiner
+        if (point->joinCount == 1){
+            char base [point->baseLength + 1];
+            memcpy(base, point->name, point->baseLength);
+            base[point->baseLength] = '\0';
+            point->array = getNameSlot(base, arrayNames, &module->arrayCount);
+        }
+    }
+
+    tasFreeVarMgr(slotNames);
+    tasFreeVarMgr(arrayNames);
+}
+
+// Creates a tile for each character of the text in one pass over it, tileCount must be how many tiles it has
+// Then links remote activators, resolves variable slots and spans, and compiles the tiles
+// Returns NULL if a remote activator can't be linked
+static Module * buildTextModule(const char * path, const char * charList, size_t charCount, unsigned int tileCount) {
+	// Allocating room for the structure
+	Module * tlist = (Module *)malloc(sizeof(Module));
+    tlist->path = malloc(strlen(path) + 1);
+    strcpy(tlist->path, path);
+	tlist->length = tileCount;
+    tlist->image = NULL;
+    tlist->mapping = NULL;
+    tlist->mappingSize = 0;
+    tlist->bundled = NULL;
+    tlist->bundledCount = 0;
+
+	// Allocating the tile arrays together, the larger elements first so each array stays aligned
+    size_t tileSize = sizeof(unsigned int) + 3 * sizeof(int) + sizeof(char);
+    tlist->names = malloc(tileSize * (tileCount > 0 ? tileCount : 1));
+    tlist->links = (int *)(tlist->names + tileCount);
+    tlist->rightEnds = tlist->links + tileCount;
+    tlist->leftEnds = tlist->rightEnds + tileCount;
+    tlist->types = (char *)(tlist->leftEnds + tileCount);
+	unsigned int foundTiles = 0; // How many real tiles have been found
+
+    // Every tile could have its own name, so there is never a need to grow these
+    // A name is at most all the characters of the file, and a tile with no name is named 0
+    tlist->points = malloc(sizeof(Point) * (tileCount > 0 ? tileCount : 1));
+    tlist->pointCount = 0;
+    tlist->nameText = malloc(charCount + 2 * tileCount + 1);
+    size_t nameLength = 0; // How much of the name text is used
+    struct varmgr * pointNames = tasCreateVarMgr(); // Maps a name to its point index + 1
+
+    bool activateNextTile = false; // Used for . initializers
+    tlist->initial = malloc(sizeof(unsigned int) * (tileCount > 0 ? tileCount : 1));
+    tlist->initialCount = 0;
+
+	for (size_t i = 0; i < charCount; i++){
+		// Each time a non-alphanumeric character appears, continue
+		// until another non-alphanumeric characters appears to get the whole
+		// points
+		
+		if (isTileChar(charList[i])){
+            // Creating a new tile
+			tlist->types[foundTiles] = charList[i];
+
+            // If the previous tile was a ., then this tile should be activated
+            if (activateNextTile){
+                activateNextTile = false;
+                tlist->initial[tlist->initialCount] = foundTiles;
+                tlist->initialCount++;
+            }
+
+			// Iterating to find the point
+            // The name is written onto the end of the name text, and only kept there if it is new
+            char * name = tlist->nameText + nameLength;
+			size_t j = 1;
+            // This loop will continue until it finds a non-alphanumeric character or colon or the end of the string
+			while (i + j < charCount && (isalnum((unsigned char)charList[i + j]) || charList[i + j] == ':')){
+				j++;
+			}
+            memcpy(name, charList + i + 1, j - 1);
+
+            // If nothing was found, the point is named 0
+			if (j == 1){
+				name[0] = '0';
+				name[1] = '\0';
+			} else {
+                name[j - 1] = '\0';
+            }
+
+            // Interning the name so every tile with the same name shares one point
+            int point = tasGetVar(name, pointNames) - 1;
+            if (point == -1){
+                point = (int)tlist->pointCount;
+                tlist->points[point].name = name;
+                tlist->pointCount++;
+                tasSetVar(name, point + 1, pointNames);
+                nameLength += (j == 1 ? 1 : j - 1) + 1;
+            }
+            tlist->names[foundTiles] = (unsigned int)point;
+			foundTiles++;
+			i = i + j - 1; // Move up to that name
+
+		} else if (charList[i] == '.'){
+            activateNextTile = true;
+        }
+
+	}
+    tasFreeVarMgr(pointNames);
+    tlist->points = realloc(tlist->points, sizeof(Point) * (tlist->pointCount > 0 ? tlist->pointCount : 1));
+    // Linking remote activators, a module that can't be linked is still compiled so it can be freed like any other
+    bool linked = linkRemoteActivators(tlist);
+    resolveVariableSlots(tlist);
+    resolveSpans(tlist);
+    compileModule(tlist);
+    if (!linked){
+        tasFreeModule(tlist);
+        return NULL;
+    }
+	return tlist;
+}
+
+Module * tasLoadTextModule(const char * fileName) {
+	size_t charCount;
+	unsigned int tileCount;
+	char * charList = readProgram(fileName, &charCount, &tileCount);
+    if (charList == NULL){
+        return NULL;
+    }
+    Module * module = buildTextModule(fileName, charList, charCount, tileCount);
+    free(charList);
+    return module;
+}
+
+Module * tasLoadTextBuffer(const char * path, const char * text, size_t length){
+    unsigned int tileCount = 0;
+    for (size_t i = 0; i < length; i++){
+        if (isTileChar(text[i])){
+            tileCount++;
+        }
+    }
+    return buildTextModule(path, text, length, tileCount);
+}
+
+
+// Binary images are written by PREPPER next to the .ptas file they were made from, with a b on the end of the extension
+// They hold everything tasLoadTextModule works out, laid out so the tile arrays can be used straight from the mapped file
+#define IMAGE_MAGIC "TASI"
+#define IMAGE_VERSION 2
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+typedef struct ImageHeaderStruct {
+    char magic [4];
+    unsigned int version; // Images with any other version are ignored and the text is loaded instead
+    unsigned int byteOrder; // Images are only used on machines with the same byte order as the one that wrote them
+    unsigned int length;
+    unsigned int pointCount;
+    unsigned int joinSlotCount;
+    unsigned int nameTextLength;
+    unsigned int slotCount;
+    unsigned int arrayCount;
+    unsigned int initialCount;
+    long long sourceSize; // The size and modification time of the text the image was made from, so stale images are skipped
+    long long sourceTime;
+} imageHeader;
+
+// A point with its pointers replaced by offsets
+typedef struct ImagePointStruct {
+    unsigned int name; // Where the name starts in the name text
+    int slot;
+    int array;
+    unsigned int joinStart; // Where the join slots start in the image's join slots
+    unsigned int joinCount;
+    unsigned int baseLength;
+} imagePoint;
+
+// After the header come names, links, rightEnds, leftEnds, initial, points, join slots, types and then the name text
+// Everything up to the types is 4 byte values so no padding is needed between them
+static size_t imageSize(imageHeader * header){
+    return sizeof(imageHeader)
+           + (size_t)header->length * (sizeof(unsigned int) + 3 * sizeof(int))
+           + (size_t)header->initialCount * sizeof(unsigned int)
+           + (size_t)header->pointCount * sizeof(imagePoint)
+           + (size_t)header->joinSlotCount * sizeof(int)
+           + header->length
+           + header->nameTextLength;
+}
+
+// Gets the size and modification time of a file, returns false if it doesn't exist
+// The time is in nanoseconds where the platform keeps them, so a file changed twice in one second is still seen as changed
+static bool getSourceStamp(const char * fileName, long long * size, long long * time){
+    struct stat info;
+    if (stat(fileName, &info) != 0){
+        return false;
+    }
+    *size = (long long)info.st_size;
+#if defined(__APPLE__)
+    *time = (long long)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+    *time = (long long)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#else
+    *time = (long long)info.st_mtime;
+#endif
+    return true;
+}
+
+// Writes a module's image at the current position of a file
+static bool writeImage(Module * module, FILE * imageFile){
+    imageHeader header;
+    memset(&header, 0, sizeof(imageHeader));
+    memcpy(header.magic, IMAGE_MAGIC, 4);
+    header.version = IMAGE_VERSION;
+    header.byteOrder = IMAGE_BYTE_ORDER;
+    header.length = module->length;
+    header.pointCount = module->pointCount;
+    header.slotCount = module->slotCount;
+    header.arrayCount = module->arrayCount;
+    header.initialCount = module->initialCount;
+    getSourceStamp(module->path, &header.sourceSize, &header.sourceTime);
+
+    // The names are in the name text in the order the points were made, so the last one ends it
+    if (module->pointCount > 0){
+        Point * last = &module->points[module->pointCount - 1];
+        header.nameTextLength = (unsigned int)(last->name - module->nameText) + strlen(last->name) + 1;
+    }
+
+    imagePoint * points = malloc(sizeof(imagePoint) * (module->pointCount > 0 ? module->pointCount : 1));
+    for (unsigned int i = 0; i < module->pointCount; i++){
+        Point * point = &module->points[i];
+        points[i].name = (unsigned int)(point->name - module->nameText);
+        points[i].slot = point->slot;
+        points[i].array = point->array;
+        points[i].joinStart = header.joinSlotCount;
+        points[i].joinCount = point->joinCount;
+        points[i].baseLength = point->baseLength;
+        header.joinSlotCount += point->joinCount;
+    }
+
+    fwrite(&header, sizeof(imageHeader), 1, imageFile);
+    fwrite(module->names, sizeof(unsigned int), module->length, imageFile);
+    fwrite(module->links, sizeof(int), module->length, imageFile);
+    fwrite(module->rightEnds, sizeof(int), module->length, imageFile);
+    fwrite(module->leftEnds, sizeof(int), module->length, imageFile);
+    fwrite(module->initial, sizeof(unsigned int), module->initialCount, imageFile);
+    fwrite(points, sizeof(imagePoint), module->pointCount, imageFile);
+    for (unsigned int i = 0; i < module->pointCount; i++){
+        if (module->points[i].joinCount > 0){
+            fwrite(module->points[i].joinSlots, sizeof(int), module->points[i].joinCount, imageFile);
+        }
+    }
+    fwrite(module->types, 1, module->length, imageFile);
+    fwrite(module->nameText, 1, header.nameTextLength, imageFile);
+
+    free(points);
+    return !ferror(imageFile);
+}
+
+bool tasWriteModuleImage(Module * module, const char * imageName){
+    FILE * imageFile = fopen(imageName, "wb");
+    if (imageFile == NULL){
+        printf("Could not write image \"%s\"\n", imageName);
+        return false;
+    }
+    bool written = writeImage(module, imageFile);
+    fclose(imageFile);
+    return written;
+}
+
+// Maps a whole file into memory read only, returns NULL if it can't be opened
+// Where mmap isn't available the file is read into memory instead
+static void * mapImage(const char * imageName, size_t * size){
+#ifdef TAS_MMAP
+    int descriptor = open(imageName, O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0){
+        close(descriptor);
+        return NULL;
+    }
+    *size = (size_t)info.st_size;
+    void * image = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    return image == MAP_FAILED ? NULL : image;
+#else
+    unsigned int ignored;
+    FILE * imageFile = fopen(imageName, "rb");
+    if (imageFile == NULL){
+        return NULL;
+    }
+    fclose(imageFile);
+    return readProgram(imageName, size, &ignored);
+#endif
+}
+
+static void unmapImage(void * image, size_t size){
+#ifdef TAS_MMAP
+    munmap(image, size);
+#else
+    free(image);
+#endif
+}
+
+// Checks that every index in the image is in range, so a damaged image can't send the interpreter off the end of an array
+// Spans have to run away from their tile, as activating one only stops when it reaches its end, and every remote
+// activator needs a tile to activate
+static bool checkImage(imageHeader * header, unsigned int * names, int * links, int * rightEnds, int * leftEnds,
+                unsigned int * initial, imagePoint * points, int * joinSlots, char * types, char * nameText){
+    if (header->nameTextLength > 0 && nameText[header->nameTextLength - 1] != '\0'){
+        return false;
+    }
+    for (unsigned int i = 0; i < header->length; i++){
+        if (names[i] >= header->pointCount
+            || links[i] < -1 || links[i] >= (int)header->length
+            || (types[i] == ',' && links[i] == -1)
+            || rightEnds[i] <= (int)i || rightEnds[i] > (int)header->length
+            || leftEnds[i] < -1 || leftEnds[i] >= (int)i){
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < header->initialCount; i++){
+        if (initial[i] >= header->length){
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < header->pointCount; i++){
+        // Joined names are built from the first baseLength characters of the name, and dense arrays are indexed by the first join
+        if (points[i].name >= header->nameTextLength
+            || (size_t)points[i].name + points[i].baseLength >= header->nameTextLength
+            || (size_t)points[i].joinStart + points[i].joinCount > header->joinSlotCount
+            || (points[i].slot != -1 && points[i].slot >= (int)header->slotCount)
+            || (points[i].array != -1 && (points[i].array >= (int)header->arrayCount || points[i].joinCount == 0))){
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < header->joinSlotCount; i++){
+        if (joinSlots[i] < -1 || joinSlots[i] >= (int)header->slotCount){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Builds a module from the image of one module, returning NULL if it can't be used
+// The tile arrays and names are used where they are in the image, only the points and instructions are built
+static Module * moduleFromImage(void * image, size_t size, const char * name){
+    // Images from another version or a different machine are left for the text loader
+    imageHeader * header = (imageHeader *)image;
+    if (size < sizeof(imageHeader)
+        || memcmp(header->magic, IMAGE_MAGIC, 4) != 0
+        || header->version != IMAGE_VERSION
+        || header->byteOrder != IMAGE_BYTE_ORDER
+        || imageSize(header) != size){
+        return NULL;
+    }
+
+    char * section = (char *)image + sizeof(imageHeader);
+    unsigned int * names = (unsigned int *)section;
+    int * links = (int *)(names + header->length);
+    int * rightEnds = links + header->length;
+    int * leftEnds = rightEnds + header->length;
+    unsigned int * initial = (unsigned int *)(leftEnds + header->length);
+    imagePoint * points = (imagePoint *)(initial + header->initialCount);
+    int * joinSlots = (int *)(points + header->pointCount);
+    char * types = (char *)(joinSlots + header->joinSlotCount);
+    char * nameText = types + header->length;
+
+    if (!checkImage(header, names, links, rightEnds, leftEnds, initial, points, joinSlots, types, nameText)){
+        return NULL;
+    }
+
+    Module * module = (Module *)malloc(sizeof(Module));
+    module->path = malloc(strlen(name) + 1);
+    strcpy(module->path, name);
+    module->image = image;
+    module->mapping = NULL;
+    module->mappingSize = 0;
+    module->bundled = NULL;
+    module->bundledCount = 0;
+    module->length = header->length;
+    module->names = names;
+    module->links = links;
+    module->rightEnds = rightEnds;
+    module->leftEnds = leftEnds;
+    module->types = types;
+    module->nameText = nameText;
+    module->initial = initial;
+    module->initialCount = header->initialCount;
+    module->slotCount = header->slotCount;
+    module->arrayCount = header->arrayCount;
+
+    module->pointCount = header->pointCount;
+    module->points = malloc(sizeof(Point) * (header->pointCount > 0 ? header->pointCount : 1));
+    for (unsigned int i = 0; i < header->pointCount; i++){
+        Point * point = &module->points[i];
+        point->name = nameText + points[i].name;
+        point->slot = points[i].slot;
+        point->array = points[i].array;
+        point->joinSlots = points[i].joinCount > 0 ? joinSlots + points[i].joinStart : NULL;
+        point->joinCount = points[i].joinCount;
+        point->baseLength = points[i].baseLength;
+    }
+
+    compileModule(module);
+    return module;
+}
+
+// Bundles are written by PREPPER -l and hold the image of a program and of every module it can call
+// They use the same .ptasb name as an image of the program on its own
+#define BUNDLE_MAGIC "TASB"
+#define BUNDLE_VERSION 2
+
+typedef struct BundleHeaderStruct {
+    char magic [4];
+    unsigned int version;
+    unsigned int byteOrder;
+    unsigned int moduleCount; // The first module is the program, the others are what it calls
+    long long sourceSize; // The size and modification time of the program's text, so stale bundles are skipped
+    long long sourceTime;
+} bundleHeader;
+
+// Where one module's image is in a bundle
+typedef struct BundleEntryStruct {
+    unsigned int name; // Where the name calls use for the module starts in the bundle's name text
+    unsigned int nameLength;
+    unsigned int path; // Where the path the module was read from starts in the name text
+    unsigned int pathLength;
+    unsigned long long offset; // From the start of the bundle, always a multiple of 8
+    unsigned long long size;
+    long long sourceSize; // The size and modification time of the module's text, so a bundle with a changed callee is skipped
+    long long sourceTime;
+} bundleEntry;
+
+// Pads a file with zeros up to a multiple of 8 so the next image in it stays aligned
+static void alignImageFile(FILE * imageFile){
+    long position = ftell(imageFile);
+    while (position % 8 != 0){
+        fputc('\0', imageFile);
+        position++;
+    }
+}
+
+bool tasWriteModuleBundle(Module ** modules, char ** names, unsigned int count, const char * bundleName){
+    FILE * bundleFile = fopen(bundleName, "wb");
+    if (bundleFile == NULL){
+        printf("Could not write bundle \"%s\"\n", bundleName);
+        return false;
+    }
+
+    bundleHeader header;
+    memset(&header, 0, sizeof(bundleHeader));
+    memcpy(header.magic, BUNDLE_MAGIC, 4);
+    header.version = BUNDLE_VERSION;
+    header.byteOrder = IMAGE_BYTE_ORDER;
+    header.moduleCount = count;
+    getSourceStamp(modules[0]->path, &header.sourceSize, &header.sourceTime);
+
+    // The entries are written once the images are and their offsets are known
+    bundleEntry * entries = calloc(count > 0 ? count : 1, sizeof(bundleEntry));
+    unsigned int nameLength = 0;
+    for (unsigned int i = 0; i < count; i++){
+        entries[i].name = nameLength;
+        entries[i].nameLength = strlen(names[i]);
+        nameLength += entries[i].nameLength;
+    }
+    for (unsigned int i = 0; i < count; i++){
+        entries[i].path = nameLength;
+        entries[i].pathLength = strlen(modules[i]->path);
+        nameLength += entries[i].pathLength;
+        getSourceStamp(modules[i]->path, &entries[i].sourceSize, &entries[i].sourceTime);
+    }
+
+    fwrite(&header, sizeof(bundleHeader), 1, bundleFile);
+    fwrite(entries, sizeof(bundleEntry), count, bundleFile);
+    for (unsigned int i = 0; i < count; i++){
+        fwrite(names[i], 1, entries[i].nameLength, bundleFile);
+    }
+    for (unsigned int i = 0; i < count; i++){
+        fwrite(modules[i]->path, 1, entries[i].pathLength, bundleFile);
+    }
+    for (unsigned int i = 0; i < count; i++){
+        alignImageFile(bundleFile);
+        entries[i].offset = ftell(bundleFile);
+        writeImage(modules[i], bundleFile);
+        entries[i].size = ftell(bundleFile) - entries[i].offset;
+    }
+
+    fseek(bundleFile, sizeof(bundleHeader), SEEK_SET);
+    fwrite(entries, sizeof(bundleEntry), count, bundleFile);
+
+    bool written = !ferror(bundleFile);
+    fclose(bundleFile);
+    free(entries);
+    return written;
+}
+
+// Builds every module in a bundle and links the function calls between them, returning the program's module
+// Returns NULL if the bundle can't be used, leaving it for the caller to unmap
+static Module * moduleFromBundle(void * bundle, size_t size){
+    bundleHeader * header = (bundleHeader *)bundle;
+    if (size < sizeof(bundleHeader)
+        || header->version != BUNDLE_VERSION
+        || header->byteOrder != IMAGE_BYTE_ORDER
+        || header->moduleCount == 0
+        || (size - sizeof(bundleHeader)) / sizeof(bundleEntry) < header->moduleCount){
+        return NULL;
+    }
+
+    bundleEntry * entries = (bundleEntry *)((char *)bundle + sizeof(bundleHeader));
+    char * nameText = (char *)(entries + header->moduleCount);
+    size_t nameSpace = size - sizeof(bundleHeader) - sizeof(bundleEntry) * header->moduleCount;
+
+    Module ** modules = calloc(header->moduleCount, sizeof(Module *));
+    struct varmgr * bundleNames = tasCreateVarMgr(); // Maps the name of each module to its index + 1
+    bool usable = true;
+    for (unsigned int i = 0; i < header->moduleCount && usable; i++){
+        bundleEntry * entry = &entries[i];
+        if ((size_t)entry->name + entry->nameLength > nameSpace || (size_t)entry->path + entry->pathLength > nameSpace
+            || entry->offset % 8 != 0 || entry->offset > size || entry->size > size - entry->offset){
+            usable = false;
+            break;
+        }
+
+        // A module whose text has changed since the bundle was made means the bundle is stale, the program's own
+        // text is checked by the caller, and modules whose text isn't there any more are used as they are
+        char path [entry->pathLength + 1];
+        memcpy(path, nameText + entry->path, entry->pathLength);
+        path[entry->pathLength] = '\0';
+        long long sourceSize;
+        long long sourceTime;
+        if (i > 0 && getSourceStamp(path, &sourceSize, &sourceTime)
+            && (sourceSize != entry->sourceSize || sourceTime != entry->sourceTime)){
+            usable = false;
+            break;
+        }
+
+        char name [entry->nameLength + 1];
+        memcpy(name, nameText + entry->name, entry->nameLength);
+        name[entry->nameLength] = '\0';
+        modules[i] = moduleFromImage((char *)bundle + entry->offset, entry->size, name);
+        usable = modules[i] != NULL;
+        tasSetVar(name, i + 1, bundleNames);
+    }
+
+    if (!usable){
+        for (unsigned int i = 0; i < header->moduleCount; i++){
+            if (modules[i] != NULL){
+                tasFreeModule(modules[i]);
+            }
+        }
+        free(modules);
+        tasFreeVarMgr(bundleNames);
+        return NULL;
+    }
+
+    // Linking the calls up front, so none of them have to look for their file while running
+    for (unsigned int i = 0; i < header->moduleCount; i++){
+        for (unsigned int j = 0; j < modules[i]->length; j++){
+            Call * call = modules[i]->code[j].call;
+            if (call != NULL){
+                int callee = tasGetVar(call->fileName, bundleNames) - 1;
+                call->module = callee == -1 ? NULL : modules[callee];
+            }
+        }
+    }
+    tasFreeVarMgr(bundleNames);
+
+    Module * program = modules[0];
+    program->bundled = modules;
+    program->bundledCount = header->moduleCount;
+    return program;
+}
+
+// Loads a module from an image or a bundle, returning NULL if there isn't one or it can't be used
+static Module * loadImageModule(const char * imageName, const char * textName){
+    size_t size;
+    void * image = mapImage(imageName, &size);
+    if (image == NULL){
+        return NULL;
+    }
+
+    // Images and bundles older than their text are left for the text loader
+    long long sourceSize;
+    long long sourceTime;
+    bool hasSource = getSourceStamp(textName, &sourceSize, &sourceTime);
+    Module * module = NULL;
+    if (size >= sizeof(bundleHeader) && memcmp(image, BUNDLE_MAGIC, 4) == 0){
+        bundleHeader * header = (bundleHeader *)image;
+        if (!hasSource || (sourceSize == header->sourceSize && sourceTime == header->sourceTime)){
+            module = moduleFromBundle(image, size);
+        }
+    } else if (size >= sizeof(imageHeader)){
+        imageHeader * header = (imageHeader *)image;
+        if (!hasSource || (sourceSize == header->sourceSize && sourceTime == header->sourceTime)){
+            module = moduleFromImage(image, size, imageName);
+        }
+    }
+
+    if (module == NULL){
+        unmapImage(image, size);
+        return NULL;
+    }
+    module->mapping = image;
+    module->mappingSize = size;
+    return module;
+}
+
+// A .ptas file is loaded from its .ptasb image when there is an up to date one, and running a .ptasb
+// falls back on the .ptas next to it when the image can't be used
+Module * tasLoadModule(const char * fileName){
+    size_t length = strlen(fileName);
+    bool isImage = length > 6 && strcmp(fileName + length - 6, ".ptasb") == 0;
+
+    char textName [length + 1];
+    char imageName [length + 2];
+    strcpy(textName, fileName);
+    strcpy(imageName, fileName);
+    if (isImage){
+        textName[length - 1] = '\0';
+    } else {
+        strcat(imageName, "b");
+    }
+
+    Module * module = loadImageModule(imageName, textName);
+    if (module != NULL){
+        return module;
+    }
+    return tasLoadTextModule(textName);
+}
+
+void tasFreeModule(Module * module){
+    // Freeing the modules that came from the same bundle, the first of them is this one
+    for (unsigned int i = 1; i < module->bundledCount; i++){
+        tasFreeModule(module->bundled[i]);
+    }
+    free(module->bundled);
+
+    // Freeing the tiles and their points, the join slots of images are part of the image
+    for (unsigned int i = 0; i < module->pointCount && module->image == NULL; i++){
+        free(module->points[i].joinSlots);
+    }
+    free(module->points);
+    if (module->mapping != NULL){
+        unmapImage(module->mapping, module->mappingSize);
+    }
+    if (module->image == NULL){
+        free(module->nameText);
+        free(module->names);
+        free(module->initial);
+    }
+    freeCode(module);
+    free(module->path);
+    free(module);
+}
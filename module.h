@@ -0,0 +1,167 @@
+
+#ifndef TAS_MODULE_H
+#define TAS_MODULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Every distinct name in a module has one point, shared by all the tiles with that name
+typedef struct PointStruct{
+	char * name; // The name, stored in the module's name text
+    int slot; // Index into the variable slots, -1 if the name has a joiner (:) and must be resolved at runtime
+    int array; // The dense array for names with exactly one joiner i.e. arr:i, -1 otherwise
+    int * joinSlots; // The slots of the names after each joiner, -1 for an empty name
+    unsigned int joinCount; // How many joiners are in the name
+    unsigned int baseLength; // The length of the name before the first joiner
+} Point;
+
+// Every tile is lowered into one of these before running
+enum Opcode {
+    OP_NOP, // Tiles that do nothing when activated i.e. | * _
+    OP_ACTIVATE_RIGHT, // >
+    OP_ACTIVATE_LEFT, // <
+    OP_POKE, // } {
+    OP_DEACTIVATE_LEFT, // (
+    OP_DEACTIVATE_RIGHT, // )
+    OP_REMOTE, // ,
+    OP_COMPARE, // ?
+    OP_ASSIGN, // =
+    OP_INCREMENT, // +
+    OP_DECREMENT, // -
+    OP_INPUT, // "
+    OP_PARAMETER, // '
+    OP_DESTROY, // ~
+    OP_CALL, // &
+    OP_OUTPUT_INT, // @
+    OP_RETURN, // ^
+    OP_OUTPUT_CHAR, // $
+    OP_NEWLINE, // ;
+    OP_COUNT
+};
+
+enum OperandKind {
+    OPERAND_CONSTANT, // A count of units, or 0 when there is nothing to read
+    OPERAND_SLOT, // A variable without a joiner
+    OPERAND_POINT // A variable with a joiner that is resolved when read
+};
+
+// A value read from a neighbouring tile by ? and =
+typedef struct OperandStruct {
+    char kind;
+    int value; // The constant value, or the variable slot
+    Point * point; // Only used for OPERAND_POINT
+} Operand;
+
+typedef struct CallStruct {
+    char * fileName; // The point name with .ptas added
+    struct ModuleStruct * module; // The module being called, found on the first call
+    const struct IntrinsicStruct * intrinsic; // The native version of the module being called, if it has one
+    Point ** arguments; // The references to the left, closest first
+    unsigned int argumentCount;
+    Point ** returnHolders; // The references to the right, closest first
+    unsigned int returnHolderCount;
+} Call;
+
+// Modules with more tiles than this are never run without a frame, so leaf calls stay short
+#define MAX_LEAF_TILES 64
+
+// Loops with more variables than this are still run natively but never in closed form
+#define MAX_LOOP_VARIABLES 16
+
+// One update a loop body makes, = + or - on a variable without a joiner
+typedef struct LoopStepStruct {
+    unsigned char op; // OP_ASSIGN, OP_INCREMENT or OP_DECREMENT
+    int slot; // The variable being updated
+    Operand left; // The values added together by =, never OPERAND_POINT
+    Operand right;
+} LoopStep;
+
+// A ? whose span to the right only updates variables without joiners and ends with a , back to the ?
+// Whenever the ? is the only thing activated, every iteration of it can be run at once instead of tile by tile
+typedef struct LoopStruct {
+    LoopStep * steps; // The updates of the body in the order they are made
+    unsigned int stepCount;
+    unsigned int tileCount; // How many tiles the body has, including the ,
+
+    // What one iteration does as an affine map over the variables it uses, so many can be applied at once
+    // Row r gives the new value of slots[r] from the old ones, with the last column for the constant
+    unsigned int * slots; // The variables the body and the ? use
+    unsigned int slotCount;
+    unsigned int * transform; // (slotCount + 1) * (slotCount + 1) values, all wrapping like the interpreter
+
+    // Set when the iterations can be counted up front, one side of the ? never changes and the other
+    // moves towards it by the same step every iteration
+    int counter; // Which of slots steps, -1 if the loop can only be run natively
+    int step; // How much the counter changes by each iteration
+    bool counterOnRight; // Whether the counter is the right side of the ?
+} Loop;
+
+typedef struct InstructionStruct {
+    unsigned char op; // The Opcode
+    int target; // The tile activated by pokes and remote activators
+    int rightEnd; // The span to the right covers the tiles after this one up to but not including rightEnd
+    int leftEnd; // The span to the left covers the tiles before this one down to but not including leftEnd
+    Operand left; // The left value of ? and =
+    Operand right; // The right value of ? and =
+    Point * point; // The variable this tile works on
+    Call * call; // Only used for function calls
+    Loop * loop; // Only used for ? tiles that make a loop that can be run natively
+} Instruction;
+
+// A loaded program
+// Nothing in it changes while running, so every call to the same file shares one module
+typedef struct ModuleStruct {
+    char * path; // The file the module was loaded from
+	unsigned int length; // How many tiles there are
+
+    // The tiles are stored as parallel arrays in one allocation
+    unsigned int * names; // The point of each tile, an index into points
+    int * links; // The tile each remote activator (,) activates, -1 for other tiles
+    int * rightEnds; // Where the span to the right of each tile ends, see Instruction
+    int * leftEnds; // Where the span to the left of each tile ends
+    char * types; // The type of each tile
+
+    Point * points; // The variable, activation point, or filename that tiles work on
+    unsigned int pointCount; // How many distinct point names there are
+    char * nameText; // The names of every point one after another
+    Instruction * code; // The compiled instruction for each tile
+    unsigned int slotCount; // How many variable slots there are
+    unsigned int arrayCount; // How many dense arrays there are
+    unsigned int * initial; // The tiles activated by . initializers, in order
+    unsigned int initialCount; // How many tiles are activated by initializers
+    bool pure; // Whether it has no input or output tiles, so a call's return values only depend on its arguments
+    bool leaf; // Whether it is pure, small, makes no calls and only has variables without joiners, so calls to it can run without a frame
+
+    // When loaded from a binary image, the arrays above that don't hold pointers point straight into it
+    void * image; // This module's part of a mapped image, NULL for modules tokenised from text
+    void * mapping; // The mapped file, only set on the module that unmaps it
+    size_t mappingSize;
+    struct ModuleStruct ** bundled; // The other modules loaded with this one from a bundle, freed along with it
+    unsigned int bundledCount;
+} Module;
+
+// Returns the point of a tile
+Point * tasTilePoint(Module * module, unsigned int index);
+
+// The loaders return NULL if the program can't be read or a remote activator in it has no tile to activate
+
+// Reads a program and builds a module from it, using its binary image when one is up to date
+Module * tasLoadModule(const char * fileName);
+
+// Reads and tokenises a text program without looking for a binary image
+Module * tasLoadTextModule(const char * fileName);
+
+// Tokenises a text program that is already in memory, such as one preprocessed from .tas source
+// path is only used to name the module, the text is not kept
+Module * tasLoadTextBuffer(const char * path, const char * text, size_t length);
+
+// Writes a module out as a binary image that tasLoadModule can use instead of the text
+bool tasWriteModuleImage(Module * module, const char * imageName);
+
+// Writes modules out as one bundle that tasLoadModule uses in place of the text of the first module
+// The function calls between them are linked when the bundle is loaded, names are what the calls use i.e. stdadd.ptas
+bool tasWriteModuleBundle(Module ** modules, char ** names, unsigned int count, const char * bundleName);
+
+void tasFreeModule(Module * module);
+
+#endif //TAS_MODULE_H
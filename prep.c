@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "prep.h"
+#include "varmgr.h"
+
+#define READ_BLOCK_SIZE (1 << 16)
+
+#define BASE62_DIGITS 6 // Enough for any int
+
+static const char BASE62 [62] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// Raw text being built up, grown as characters are added
+typedef struct RawTextStruct {
+    char * text;
+    size_t length;
+    size_t capacity;
+} rawText;
+
+// Writes a number as a base 62 string, to minimize the number of characters
+// The least significant digit comes first, shortName needs room for BASE62_DIGITS + 1 characters
+static unsigned int numToBase62(unsigned int num, char * shortName){
+    if (num == 0){
+        shortName[0] = '0';
+        shortName[1] = '\0';
+        return 1;
+    }
+    unsigned int i = 0;
+    while (num > 0){
+        shortName[i] = BASE62[num % 62];
+        num /= 62;
+        i++;
+    }
+    shortName[i] = '\0';
+    return i;
+}
+
+// Adds characters to the end of the raw text, growing it when needed
+static void appendRaw(rawText * raw, const char * characters, size_t count){
+    if (raw->length + count + 1 > raw->capacity){
+        while (raw->length + count + 1 > raw->capacity){
+            raw->capacity *= 2;
+        }
+        raw->text = realloc(raw->text, raw->capacity);
+    }
+    memcpy(raw->text + raw->length, characters, count);
+    raw->length += count;
+}
+
+// Adds the short name of a variable to the raw text
+// Names are numbered from 1 in the order they first appear, the number is kept in the interner so each name is only numbered once
+static void appendShortName(rawText * raw, struct varmgr * interner, char * name){
+    int num = tasGetVar(name, interner);
+    if (num == 0){
+        num = interner->varCount + 1;
+        tasSetVar(name, num, interner);
+    }
+    char shortName [BASE62_DIGITS + 1];
+    unsigned int length = numToBase62((unsigned int)num, shortName);
+    appendRaw(raw, shortName, length);
+}
+
+char * tasReadSource(FILE * stream, size_t * length){
+    if (stream == NULL){
+        return NULL;
+    }
+
+    size_t capacity = READ_BLOCK_SIZE;
+    char * text = malloc(capacity + 1);
+    *length = 0;
+    size_t got;
+    while ((got = fread(text + *length, 1, capacity - *length, stream)) > 0){
+        *length += got;
+        if (*length == capacity){
+            capacity *= 2;
+            text = realloc(text, capacity + 1);
+        }
+    }
+    if (ferror(stream)){
+        free(text);
+        return NULL;
+    }
+    text[*length] = '\0';
+    return text;
+}
+
+// Works through the source one character at a time, the raw text is never longer than the source
+// except when short names come out longer than the names they replace
+char * tasPreprocessSource(const char * source, size_t length, bool smallVarNames, size_t * rawLength){
+    struct varmgr * interner = tasCreateVarMgr(); // Maps each variable name to its number
+
+    rawText raw;
+    raw.capacity = length + 16;
+    raw.text = malloc(raw.capacity);
+    raw.length = 0;
+
+    char tempChar;
+    int inComment = 0;
+
+    bool inVar = false;
+
+    size_t tempVarCapacity = 64;
+    char * tempVarName = malloc(tempVarCapacity);
+    size_t tempVarLength = 0;
+
+    char lastCharAdded = '\0';
+    char lastTileTypeAdded = '\0';
+
+    for (size_t i = 0; i < length; i++){
+        tempChar = source[i];
+        if (tempChar == '#'){
+            inComment = 1;
+        } else if (tempChar == '\n'){
+            inComment = 0;
+            tempChar = '_'; // Replacing the newline with a blocker
+        }
+        if (tempChar == ' ' || inComment){
+            continue;
+        }
+
+        if (isalnum((unsigned char)tempChar) && smallVarNames && lastTileTypeAdded != '&'){
+            // This character is part of a variable name, either starting a name or adding to it
+            if (!inVar){ // This is the start of a variable name
+                inVar = true;
+                tempVarLength = 0;
+            }
+            // Adding this character to the tempVarName, leaving room for the null terminator
+            if (tempVarLength + 2 > tempVarCapacity){
+                tempVarCapacity *= 2;
+                tempVarName = realloc(tempVarName, tempVarCapacity);
+            }
+            tempVarName[tempVarLength] = tempChar;
+            tempVarLength++;
+        } else { // This character is not part of a variable name because it is not alphanumeric
+            if (inVar){
+                inVar = false;
+                tempVarName[tempVarLength] = '\0'; // Adding the null terminator
+                appendShortName(&raw, interner, tempVarName);
+                if (tempChar != '_' || lastCharAdded != '_') {
+                    appendRaw(&raw, &tempChar, 1); // Putting the non-alphanumeric character in the text
+                    lastTileTypeAdded = tempChar;
+                    lastCharAdded = tempChar;
+                }
+            } else {
+                // This character is not part of a variable name
+                // We will just add it to the text
+                if (tempChar != '_' || lastCharAdded != '_') {
+                    appendRaw(&raw, &tempChar, 1);
+                    lastCharAdded = tempChar;
+                    if (!isalnum((unsigned char)tempChar)){
+                        lastTileTypeAdded = tempChar;
+                    }
+                }
+            }
+        }
+    }
+
+    // End of the source but still must add the last variable name
+    if (inVar){
+        tempVarName[tempVarLength] = '\0'; // Adding the null terminator
+        appendShortName(&raw, interner, tempVarName);
+    }
+
+    free(tempVarName);
+    tasFreeVarMgr(interner);
+    raw.text[raw.length] = '\0';
+    *rawLength = raw.length;
+    return raw.text;
+}
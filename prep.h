@@ -0,0 +1,22 @@
+
+#ifndef TAS_PREP_H
+#define TAS_PREP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Turns .tas source into the raw text TAS loads, the same text PREPPER writes to a .ptas file
+// Comments and spaces are dropped, each newline becomes a blocker (_) and runs of blockers are merged into one
+// When smallVarNames is true, every variable name is mapped to a short base 62 name, names after a & are
+// left alone since they are the files being called
+
+// Reads everything left in a stream, such as stdin, into memory
+// The returned text is NUL terminated and must be freed by the caller, NULL if the stream can't be read
+char * tasReadSource(FILE * stream, size_t * length);
+
+// Preprocesses length characters of source, which don't need to be NUL terminated
+// The returned raw text is NUL terminated and must be freed by the caller
+char * tasPreprocessSource(const char * source, size_t length, bool smallVarNames, size_t * rawLength);
+
+#endif //TAS_PREP_H
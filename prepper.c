@@ -3,175 +3,241 @@
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
-char BASE62 [62] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-// When smallVarNames is true, every variable name will be mapped to a hexadecimal number as a string
-// This is because small variable names can be processed faster by the interpreter
-
-struct varNode{
-    char * name;
-    int num;
-    struct varNode * next;
-};
-
-// Converts a number to a base 62 string, to minimize the number of characters
-char * numToBase62(int num){
-    if (num == 0) return "0";
-    char * base62 = malloc(10);
-    int i = 0;
-    while (num > 0){
-        base62[i] = BASE62[num % 62];
-        num /= 62;
-        i++;
+#include "module.h"
+#include "varmgr.h"
+#include "prep.h"
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#define PREP_THREADS
+#endif
+
+// Works out the name of the .ptas file made from a .tas file, rawFileName needs room for strlen(fileName) + 5 characters
+void getRawFileName(char * fileName, char * rawFileName){
+	strcpy(rawFileName, fileName);
+	size_t i;
+	for (i = 0; i < strlen(rawFileName) && rawFileName[i] != '.'; i++);
+	
+	rawFileName[i] = '\0';
+	strcat(rawFileName, ".ptas");
+}
+
+// What happened when making a .ptas file
+#define PREP_MADE 0
+#define PREP_NOT_FOUND 1 // The .tas file could not be opened
+#define PREP_NOT_READ 2 // The .tas file could not be read
+#define PREP_NOT_WRITTEN 3 // The .ptas file could not be written
+
+// A file being made into a .ptas file, done on whichever thread takes it next
+typedef struct PrepJobStruct {
+    char * fileName;
+    int result; // One of the PREP_ values
+} prepJob;
+
+// The files being made into .ptas files, shared by every thread working on them
+typedef struct PrepWorkStruct {
+    prepJob * jobs;
+    int jobCount;
+    atomic_int nextJob; // The next job no thread has taken yet
+    bool smallVarNames;
+} prepWork;
+
+// Preprocesses a .tas file into the .ptas file next to it, returning one of the PREP_ values
+// Only touches its own files and its own tables so any number of files can be made at once
+int makeRawStackFile(char * fileName, bool smallVarNames){
+	FILE * stackFile = fopen(fileName, "r");
+	if (stackFile == NULL){
+		return PREP_NOT_FOUND;
+	}
+    size_t length;
+    char * source = tasReadSource(stackFile, &length);
+	fclose(stackFile);
+    if (source == NULL){
+        return PREP_NOT_READ;
     }
-    base62[i] = '\0';
-    return base62;
+
+    size_t rawLength;
+    char * raw = tasPreprocessSource(source, length, smallVarNames, &rawLength);
+    free(source);
+
+	char rawFileName [strlen(fileName) + 5];
+	getRawFileName(fileName, rawFileName);
+
+	FILE * rawStackFile = fopen(rawFileName, "w");
+    bool written = rawStackFile != NULL && fwrite(raw, 1, rawLength, rawStackFile) == rawLength;
+    if (rawStackFile != NULL){
+        written = fclose(rawStackFile) == 0 && written;
+    }
+    free(raw);
+	return written ? PREP_MADE : PREP_NOT_WRITTEN;
 }
 
-// Returns the node with the given name, or NULL if it is not found
-struct varNode * findValue(struct varNode * varList, char * name){
-    struct varNode * tempNode = varList;
-    while (tempNode != NULL){
-        if (strcmp(tempNode->name, name) == 0){
-            return tempNode;
-        }
-        tempNode = tempNode->next;
+// Takes jobs until there are none left, so threads that get small files take more of them
+void * prepWorker(void * argument){
+    prepWork * work = (prepWork *)argument;
+    int job;
+    while ((job = atomic_fetch_add(&work->nextJob, 1)) < work->jobCount){
+        work->jobs[job].result = makeRawStackFile(work->jobs[job].fileName, work->smallVarNames);
     }
     return NULL;
 }
 
-// Returns the last node in the linked list
-struct varNode * getLastNode(struct varNode * varList){
-    struct varNode * tempNode = varList;
-    while (tempNode->next != NULL){
-        tempNode = tempNode->next;
+// Makes every job's .ptas file using up to threadCount threads, the calling thread being one of them
+void makeRawStackFiles(prepWork * work, int threadCount){
+    if (threadCount > work->jobCount){
+        threadCount = work->jobCount;
     }
-    return tempNode;
+#ifdef PREP_THREADS
+    pthread_t threads [threadCount > 1 ? threadCount - 1 : 1];
+    int started = 0;
+    for (int i = 0; i < threadCount - 1; i++){
+        if (pthread_create(&threads[started], NULL, prepWorker, work) == 0){
+            started++;
+        }
+    }
+    prepWorker(work);
+    for (int i = 0; i < started; i++){
+        pthread_join(threads[i], NULL);
+    }
+#else
+    prepWorker(work);
+#endif
+}
+
+// Works out how many threads to make files with when it isn't given
+int defaultThreadCount(){
+#ifdef PREP_THREADS
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+#else
+    return 1;
+#endif
 }
 
-// Returns the short name of the variable using the list of variables, also updates the list if the variable is not in the list
-char * getShortName(struct varNode * varList, char * name){
-    // Creating a new node
-    struct varNode * newNode = malloc(sizeof(struct varNode));
-    newNode->name = malloc(strlen(name) + 1);
-    strcpy(newNode->name, name);
-
-    // Checking if this variable name is already in the list
-    struct varNode * tempNode = findValue(varList, name);
-    if (tempNode != NULL){ // If the variable name is already in the list
-        return numToBase62(tempNode->num); // Returning the short name of the variable
-    } else {
-        newNode->next = NULL;
-        // Setting the number of the node
-        newNode->num = getLastNode(varList)->num + 1;
-        // Adding the node to end of the linked list
-        getLastNode(varList)->next = newNode;
-
-        // Returning the short name of the variable
-        return numToBase62(newNode->num);
+// Loads a .ptas file the same way TAS does and writes its binary image beside it as a .ptasb file
+bool makeImageFile(char * fileName){
+	char rawFileName [strlen(fileName) + 5];
+	getRawFileName(fileName, rawFileName);
+	char imageFileName [strlen(rawFileName) + 2];
+	strcpy(imageFileName, rawFileName);
+	strcat(imageFileName, "b");
+
+	Module * module = tasLoadTextModule(rawFileName);
+    if (module == NULL){
+        printf("Error: remote activators in %s could not be linked\n", rawFileName);
+        return false;
     }
+	bool written = tasWriteModuleImage(module, imageFileName);
+	tasFreeModule(module);
+	return written;
 }
 
-bool makeRawStackFile(char * fileName, bool smallVarNames){
-	FILE * stackFile = fopen(fileName, "r");
-	if (stackFile == NULL){
-		printf("Could not find file \" %s \"", fileName);
-		return false;
-	}
+// Looks through the search path for the file a function call runs, returning its path or NULL if it isn't anywhere
+// The returned path must be freed by the caller
+char * findCalledFile(char * name, char ** searchPath, int searchCount){
+    for (int i = 0; i < searchCount; i++){
+        char * path = malloc(strlen(searchPath[i]) + strlen(name) + 2);
+        strcpy(path, searchPath[i]);
+        strcat(path, "/");
+        strcat(path, name);
 
-    struct varNode * varList = malloc(sizeof(struct varNode));
-    varList->next = NULL;
-    varList->num = 0;
-    varList->name = malloc(1);
-    varList->name[0] = '\0';
+        FILE * file = fopen(path, "r");
+        if (file != NULL){
+            fclose(file);
+            return path;
+        }
+        free(path);
+    }
+    return NULL;
+}
 
+// Follows the function calls of a .ptas file to every module it can reach, and writes them all into one bundle
+// A call that can't be found in the search path stops the bundle from being written
+bool makeBundleFile(char * fileName, char ** searchPath, int searchCount){
 	char rawFileName [strlen(fileName) + 5];
-	strcpy(rawFileName, fileName);
-	int i;	
-	for (i = 0; i < strlen(rawFileName) && rawFileName[i] != '.'; i++);
-	
-	rawFileName[i] = '\0';
-	strcat(rawFileName, ".ptas");
+	getRawFileName(fileName, rawFileName);
+	char bundleFileName [strlen(rawFileName) + 2];
+	strcpy(bundleFileName, rawFileName);
+	strcat(bundleFileName, "b");
 
-	FILE * rawStackFile = fopen(rawFileName, "w");
-	char tempChar;
-	int inComment = 0;
-
-    bool inVar = false;
-    int varCount = 0;
-
-    char tempVarName [50];
-    int tempVarLength = 0;
-
-    char lastCharAdded = '\0';
-    char lastTileTypeAdded = '\0';
-
-	while (!feof(stackFile)){
-		tempChar = fgetc(stackFile);
-		if (tempChar != EOF){
-			if (tempChar == '#'){
-				inComment = 1;
-			} else if (tempChar == '\n'){
-				inComment = 0;
-				tempChar = '_'; // Replacing the newline with a blocker
-			}
-			if (tempChar != ' ' && !inComment){
-                if (isalnum(tempChar) && smallVarNames && lastTileTypeAdded != '&'){
-                    // This character is part of a variable name, either starting a name or adding to it
-                    if (!inVar){ // This is the start of a variable name
-                        inVar = true;
-                        tempVarLength = 0;
-                        tempVarName[0] = '\0'; // Adding the null terminator to reset the string
-                        varCount++;
-                    }
-                    // Adding this character to the tempVarName
-                    tempVarName[tempVarLength] = tempChar;
-                    tempVarName[tempVarLength + 1] = '\0';
-                    tempVarLength++;
-                } else { // This character is not part of a variable name because it is not alphanumeric
-                    if (inVar){
-                        inVar = false;
-                        tempVarName[tempVarLength + 1] = '\0'; // Adding the null terminator
-                        char * shortName = getShortName(varList, tempVarName);
-                        fputs(shortName, rawStackFile);
-                        if (tempChar != '_' || lastCharAdded != '_') {
-                            fputc(tempChar, rawStackFile); // Putting the non-alphanumeric character in the file
-                            lastTileTypeAdded = tempChar;
-                            lastCharAdded = tempChar;
-                        }
-                    } else {
-                        // This character is not part of a variable name
-                        // We will just print it to the file
-                        if (tempChar != '_' || lastCharAdded != '_') {
-                            fputc(tempChar, rawStackFile);
-                            lastCharAdded = tempChar;
-                            if (!isalnum(tempChar)){
-                                lastTileTypeAdded = tempChar;
-                            }
-                        }
-                    }
-                }
-			}
-		} else { // End of file
-
-            // End of file but still must add variable name to the list or check for duplicates
-            if (inVar) {
-                inVar = false;
-                tempVarName[tempVarLength + 1] = '\0'; // Adding the null terminator
-                char *shortName = getShortName(varList, tempVarName);
-                fputs(shortName, rawStackFile);
+    unsigned int capacity = 4;
+    unsigned int count = 1;
+    Module ** modules = malloc(sizeof(Module *) * capacity);
+    char ** names = malloc(sizeof(char *) * capacity);
+    struct varmgr * linked = tasCreateVarMgr(); // The names of the modules already in the bundle
+
+    // The program is named the way a call to it would be, so it can call itself
+    char * baseName = strrchr(rawFileName, '/') == NULL ? rawFileName : strrchr(rawFileName, '/') + 1;
+    modules[0] = tasLoadTextModule(rawFileName);
+    if (modules[0] == NULL){
+        printf("Error: remote activators in %s could not be linked\n", rawFileName);
+        free(modules);
+        free(names);
+        tasFreeVarMgr(linked);
+        return false;
+    }
+    names[0] = malloc(strlen(baseName) + 1);
+    strcpy(names[0], baseName);
+    tasSetVar(names[0], 1, linked);
+
+    // Each module is searched for calls once it is added, so this finds everything that can be reached
+    bool missing = false;
+    for (unsigned int i = 0; i < count; i++){
+        for (unsigned int j = 0; j < modules[i]->length; j++){
+            Call * call = modules[i]->code[j].call;
+            if (call == NULL || tasGetVar(call->fileName, linked) != 0){
+                continue;
             }
+
+            char * path = findCalledFile(call->fileName, searchPath, searchCount);
+            if (path == NULL){
+                printf("\nError - %s calls %s, which is not in the search path", modules[i]->path, call->fileName);
+                tasSetVar(call->fileName, -1, linked); // Only reporting each missing file once
+                missing = true;
+                continue;
+            }
+
+            Module * called = tasLoadTextModule(path);
+            if (called == NULL){
+                printf("\nError - %s calls %s, which could not be loaded", modules[i]->path, path);
+                tasSetVar(call->fileName, -1, linked);
+                missing = true;
+                free(path);
+                continue;
+            }
+
+            if (count == capacity){
+                capacity *= 2;
+                modules = realloc(modules, sizeof(Module *) * capacity);
+                names = realloc(names, sizeof(char *) * capacity);
+            }
+            modules[count] = called;
+            names[count] = malloc(strlen(call->fileName) + 1);
+            strcpy(names[count], call->fileName);
+            count++;
+            tasSetVar(call->fileName, count, linked);
+            free(path);
         }
-	}
+    }
 
-	fclose(stackFile);
-	fclose(rawStackFile);
-	return true;
+    bool written = !missing && tasWriteModuleBundle(modules, names, count, bundleFileName);
+    for (unsigned int i = 0; i < count; i++){
+        tasFreeModule(modules[i]);
+        free(names[i]);
+    }
+    free(modules);
+    free(names);
+    tasFreeVarMgr(linked);
+    return written;
 }
 
 int main(int argc, char* argv[]){
 	char * fileNames [argc];
     int filesCount = 0;
+    char * searchPath [argc + 2]; // Where called files are looked for when linking, in order
+    int searchCount = 0;
 
 	if (argc == 1){
 		puts ("Need a file to run");
@@ -179,9 +245,27 @@ int main(int argc, char* argv[]){
 	}
     puts("Processing files...");
     bool smallVarNames = false;
+    bool makeImages = false;
+    bool makeBundles = false;
+    int threadCount = 0;
     for (int i = 1; i < argc; i++){
         if (strcmp(argv[i], "-s") == 0){
             smallVarNames = true;
+        } else if (strcmp(argv[i], "-b") == 0){
+            // Also writing a binary image of each file, which TAS loads without tokenising it
+            makeImages = true;
+        } else if (strcmp(argv[i], "-l") == 0){
+            // Linking each file with everything it calls into a bundle, written where its image would be
+            makeBundles = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            // How many files to make at once, by default one for each core
+            i++;
+            threadCount = atoi(argv[i]);
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc){
+            // A folder to look in for called files, before the current folder and stdlib
+            i++;
+            searchPath[searchCount] = argv[i];
+            searchCount++;
         } else {
             // Checking for .tas extension
             char * fileName = argv[i];
@@ -194,9 +278,42 @@ int main(int argc, char* argv[]){
         }
     }
 
-    // Making the raw stack files
+    // Called files are looked for in the same places TAS looks when running, after any given folders
+    searchPath[searchCount] = ".";
+    searchPath[searchCount + 1] = "stdlib";
+    searchCount += 2;
+
+    // Making the raw stack files, on several threads when there are several files
+    // Each file has its own tables so the files made are the same however many threads there are
+    prepJob jobs [filesCount > 0 ? filesCount : 1];
+    prepWork work;
+    work.jobs = jobs;
+    work.jobCount = filesCount;
+    atomic_init(&work.nextJob, 0);
+    work.smallVarNames = smallVarNames;
     for (int i = 0; i < filesCount; i++){
-        makeRawStackFile(fileNames[i], smallVarNames);
+        jobs[i].fileName = fileNames[i];
+        jobs[i].result = PREP_NOT_FOUND;
+    }
+    makeRawStackFiles(&work, threadCount > 0 ? threadCount : defaultThreadCount());
+
+    // Reporting in the order the files were given, then making images and bundles, which read the .ptas files just made
+    bool failed = false;
+    for (int i = 0; i < filesCount; i++){
+        if (jobs[i].result != PREP_MADE){
+            if (jobs[i].result == PREP_NOT_FOUND){
+                printf("Could not find file \" %s \"", fileNames[i]);
+            } else if (jobs[i].result == PREP_NOT_READ){
+                printf("Could not read file \" %s \"", fileNames[i]);
+            } else {
+                printf("Could not write the .ptas file for \" %s \"", fileNames[i]);
+            }
+            failed = true;
+        } else if (makeBundles){
+            failed = !makeBundleFile(fileNames[i], searchPath, searchCount) || failed;
+        } else if (makeImages){
+            failed = !makeImageFile(fileNames[i]) || failed;
+        }
     }
-	return 0;
+	return failed ? 1 : 0;
 }
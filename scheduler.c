@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "scheduler.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define SCHEDULER_THREADS
+#endif
+
+// What a task is doing
+#define TASK_QUEUED 0 // In the run queue waiting for a turn
+#define TASK_RUNNING 1 // Taking a turn, or having its finish function called
+#define TASK_PARKED 2 // Waiting for tasWake
+
+struct TasTaskStruct {
+    tasInstance * instance;
+    tasFinishFunction finish;
+    void * context;
+    int state;
+    bool woken; // tasWake was called during its turn
+    struct TasTaskStruct * next; // The next task in the run queue or the parked list
+    struct TasTaskStruct * previous; // Only used in the parked list, so a task can be taken out of the middle of it
+};
+
+struct TasSchedulerStruct {
+    unsigned long long quantum;
+    tasTask * head; // The run queue, turns are taken from the head and given back at the tail
+    tasTask * tail;
+    tasTask * parked;
+    unsigned int parkedCount;
+    unsigned int active; // How many tasks are queued or running, every run has finished or is parked when this is 0
+    bool stopping;
+#ifdef SCHEDULER_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t queued; // Signalled when a task is added to the run queue, or the threads are told to stop
+    pthread_cond_t idle; // Signalled when active gets to 0
+    pthread_t * threads;
+    unsigned int threadCount;
+#endif
+};
+
+#ifdef SCHEDULER_THREADS
+#define LOCK(scheduler) pthread_mutex_lock(&(scheduler)->lock)
+#define UNLOCK(scheduler) pthread_mutex_unlock(&(scheduler)->lock)
+#else
+#define LOCK(scheduler)
+#define UNLOCK(scheduler)
+#endif
+
+// Adds a task to the back of the run queue, the lock must be held
+static void queueTask(tasScheduler * scheduler, tasTask * task){
+    task->state = TASK_QUEUED;
+    task->next = NULL;
+    if (scheduler->tail == NULL){
+        scheduler->head = task;
+    } else {
+        scheduler->tail->next = task;
+    }
+    scheduler->tail = task;
+#ifdef SCHEDULER_THREADS
+    pthread_cond_signal(&scheduler->queued);
+#endif
+}
+
+// Takes the task at the front of the run queue, which must not be empty, the lock must be held
+static tasTask * dequeueTask(tasScheduler * scheduler){
+    tasTask * task = scheduler->head;
+    scheduler->head = task->next;
+    if (scheduler->head == NULL){
+        scheduler->tail = NULL;
+    }
+    return task;
+}
+
+// Counts a task as no longer queued or running, the lock must be held
+static void deactivateTask(tasScheduler * scheduler){
+    scheduler->active--;
+#ifdef SCHEDULER_THREADS
+    if (scheduler->active == 0){
+        pthread_cond_broadcast(&scheduler->idle);
+    }
+#endif
+}
+
+static void parkTask(tasScheduler * scheduler, tasTask * task){
+    task->state = TASK_PARKED;
+    task->previous = NULL;
+    task->next = scheduler->parked;
+    if (scheduler->parked != NULL){
+        scheduler->parked->previous = task;
+    }
+    scheduler->parked = task;
+    scheduler->parkedCount++;
+    deactivateTask(scheduler);
+}
+
+static void unparkTask(tasScheduler * scheduler, tasTask * task){
+    if (task->previous != NULL){
+        task->previous->next = task->next;
+    } else {
+        scheduler->parked = task->next;
+    }
+    if (task->next != NULL){
+        task->next->previous = task->previous;
+    }
+    scheduler->parkedCount--;
+}
+
+// Gives the task at the front of the run queue one turn, the lock must be held and is let go of during the turn
+static void takeTurn(tasScheduler * scheduler){
+    tasTask * task = dequeueTask(scheduler);
+    task->state = TASK_RUNNING;
+    task->woken = false;
+    UNLOCK(scheduler);
+    int result = tasResume(task->instance, scheduler->quantum);
+    LOCK(scheduler);
+
+    if (result == TAS_RUNNING || (result == TAS_WAITING && task->woken)){
+        queueTask(scheduler, task);
+    } else if (result == TAS_WAITING){
+        parkTask(scheduler, task);
+    } else {
+        // Finishing without the lock so the finish function can schedule or wake other runs
+        UNLOCK(scheduler);
+        if (task->finish != NULL){
+            task->finish(task->context, task->instance, result);
+        }
+        free(task);
+        LOCK(scheduler);
+        deactivateTask(scheduler);
+    }
+}
+
+#ifdef SCHEDULER_THREADS
+// Takes turns until the scheduler is freed
+static void * runSchedulerThread(void * argument){
+    tasScheduler * scheduler = (tasScheduler *)argument;
+    LOCK(scheduler);
+    while (true){
+        while (scheduler->head == NULL && !scheduler->stopping){
+            pthread_cond_wait(&scheduler->queued, &scheduler->lock);
+        }
+        if (scheduler->stopping){
+            break;
+        }
+        takeTurn(scheduler);
+    }
+    UNLOCK(scheduler);
+    return NULL;
+}
+#endif
+
+tasScheduler * tasCreateScheduler(unsigned int threadCount, unsigned long long quantum){
+    tasScheduler * scheduler = malloc(sizeof(tasScheduler));
+    scheduler->quantum = quantum > 0 ? quantum : 1;
+    scheduler->head = NULL;
+    scheduler->tail = NULL;
+    scheduler->parked = NULL;
+    scheduler->parkedCount = 0;
+    scheduler->active = 0;
+    scheduler->stopping = false;
+#ifdef SCHEDULER_THREADS
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->queued, NULL);
+    pthread_cond_init(&scheduler->idle, NULL);
+    scheduler->threads = malloc(sizeof(pthread_t) * (threadCount > 0 ? threadCount : 1));
+    scheduler->threadCount = 0;
+    for (unsigned int i = 0; i < threadCount; i++){
+        // Carrying on with fewer threads if one can't be started, tasWaitScheduler takes turns too
+        if (pthread_create(&scheduler->threads[scheduler->threadCount], NULL, runSchedulerThread, scheduler) == 0){
+            scheduler->threadCount++;
+        }
+    }
+#endif
+    return scheduler;
+}
+
+tasTask * tasSchedule(tasScheduler * scheduler, tasInstance * instance, tasFinishFunction finish, void * context){
+    tasTask * task = malloc(sizeof(tasTask));
+    task->instance = instance;
+    task->finish = finish;
+    task->context = context;
+    task->woken = false;
+    task->previous = NULL;
+    LOCK(scheduler);
+    scheduler->active++;
+    queueTask(scheduler, task);
+    UNLOCK(scheduler);
+    return task;
+}
+
+void tasWake(tasScheduler * scheduler, tasTask * task){
+    LOCK(scheduler);
+    if (task->state == TASK_PARKED){
+        unparkTask(scheduler, task);
+        scheduler->active++;
+        queueTask(scheduler, task);
+    } else if (task->state == TASK_RUNNING){
+        task->woken = true;
+    }
+    UNLOCK(scheduler);
+}
+
+unsigned int tasWaitScheduler(tasScheduler * scheduler){
+    LOCK(scheduler);
+    while (scheduler->active > 0){
+        if (scheduler->head != NULL){
+            takeTurn(scheduler);
+        } else {
+#ifdef SCHEDULER_THREADS
+            // Every queued task is taking a turn on another thread
+            pthread_cond_wait(&scheduler->idle, &scheduler->lock);
+#endif
+        }
+    }
+    unsigned int parked = scheduler->parkedCount;
+    UNLOCK(scheduler);
+    return parked;
+}
+
+void tasFreeScheduler(tasScheduler * scheduler){
+#ifdef SCHEDULER_THREADS
+    LOCK(scheduler);
+    scheduler->stopping = true;
+    pthread_cond_broadcast(&scheduler->queued);
+    UNLOCK(scheduler);
+    for (unsigned int i = 0; i < scheduler->threadCount; i++){
+        pthread_join(scheduler->threads[i], NULL);
+    }
+    free(scheduler->threads);
+    pthread_mutex_destroy(&scheduler->lock);
+    pthread_cond_destroy(&scheduler->queued);
+    pthread_cond_destroy(&scheduler->idle);
+#endif
+    // Dropping runs that never finished, whether they were still queued or parked
+    while (scheduler->head != NULL){
+        free(dequeueTask(scheduler));
+    }
+    while (scheduler->parked != NULL){
+        tasTask * task = scheduler->parked;
+        scheduler->parked = task->next;
+        free(task);
+    }
+    free(scheduler);
+}
@@ -0,0 +1,38 @@
+
+#ifndef TAS_SCHEDULER_H
+#define TAS_SCHEDULER_H
+
+#include "tas.h"
+
+// Runs many instances at once by taking turns, each one runs for a quantum of cycles then goes to the back of the queue
+// A run that stops at a " tile to wait for input is parked, taking no turns until tasWake is called for it
+// The budgets in each instance's options still apply, a run that goes over one finishes with that error
+
+typedef struct TasSchedulerStruct tasScheduler;
+typedef struct TasTaskStruct tasTask;
+
+// Called once a run has finished or stopped with an error, from whichever thread ran its last turn
+// The instance is no longer used by the scheduler and the task is freed once this returns
+typedef void (*tasFinishFunction)(void * context, tasInstance * instance, int result);
+
+// threadCount threads take turns running instances, with 0 they are only run by tasWaitScheduler on the calling thread
+// Where there are no threads every run is carried out that way
+tasScheduler * tasCreateScheduler(unsigned int threadCount, unsigned long long quantum);
+
+// Adds a run that has been started with tasStart to the back of the queue, finish can be NULL
+// The returned task is what tasWake is given, and is only valid until finish has been called
+tasTask * tasSchedule(tasScheduler * scheduler, tasInstance * instance, tasFinishFunction finish, void * context);
+
+// Puts a parked run back in the queue once its read function has input for it
+// Waking a run that isn't parked yet makes its next wait end straight away, so input that comes in during a turn isn't missed
+void tasWake(tasScheduler * scheduler, tasTask * task);
+
+// Runs turns on the calling thread until every run has finished or is parked
+// Returns how many runs are parked, they carry on after tasWake and another wait
+unsigned int tasWaitScheduler(tasScheduler * scheduler);
+
+// Stops the threads, any runs still parked are dropped without their finish function being called
+// Must not be called while tasWaitScheduler is running
+void tasFreeScheduler(tasScheduler * scheduler);
+
+#endif //TAS_SCHEDULER_H
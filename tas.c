@@ -0,0 +1,1778 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+#include "varmgr.h"
+#include "module.h"
+#include "intrinsic.h"
+#include "memo.h"
+#include "prep.h"
+#include "tas.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define readDescriptor _read
+#define writeDescriptor _write
+#else
+#include <unistd.h>
+#define readDescriptor read
+#define writeDescriptor write
+#endif
+
+// Control
+//     > - Activate right
+//     < - Activate left
+//     } - Poke right
+//     { - Poke left
+//     ( - Deactivate left
+//     ) - Deactivate right
+//     _ - Blocker
+//     . - Initializer
+//     , - Remote activator
+//     ? - Comparator
+// Value
+//     | - Unit
+//     * - Reference
+//     : - Joiner
+//     = - Assignment
+//     + - Successor
+//     - - Predecessor
+//     ~ - Destructor
+// IO
+//     & - Function call
+//     " - User Input
+//     ' - Parameter Input
+//     ; - Output newline
+//     @ - Output int
+//     $ - Output char
+//     ^ - Return value
+// MISC
+//     # - Comment
+
+
+typedef struct QueuedTileStruct {
+    unsigned int index; // The index of the tile
+    unsigned int generation; // The generation of the tile when it was queued, the entry is stale once they differ
+} queuedTile;
+
+// A ring buffer of tile indices
+// Deactivating a tile doesn't search the ring, it bumps the tile's generation so its entry is skipped when it comes up
+typedef struct TileQueueStruct {
+    queuedTile * ring; // The queued tiles in activation order, including stale entries
+    unsigned int capacity; // The size of the ring, always a power of 2
+    unsigned int head; // Where the next tile is taken from
+    unsigned int count; // How many entries are in the ring, including stale ones
+    unsigned int live; // How many tiles are actually queued
+    unsigned int tileCapacity; // How many tiles queued and generations have room for
+    bool * queued; // Whether each tile is in the queue
+    unsigned int * generations; // The current generation of each tile
+} tileQueue;
+
+
+// Every module that has been loaded, so each file is only read and parsed once
+typedef struct ModuleCacheStruct {
+    struct varmgr * paths; // Maps the path of each module to its index in modules + 1
+    Module ** modules;
+    unsigned int count;
+    unsigned int capacity;
+} moduleCache;
+
+// A loaded program, with every module it can call so nothing needs loading while it runs
+struct TasProgramStruct {
+    Module * main; // The module that is run
+    moduleCache modules; // Every module loaded for the program, freed with it
+};
+
+// Joiner names with one joiner and an index from 0 up to this are stored in dense arrays, others go in the varmgr
+#define MAX_DENSE_INDEX (1 << 22)
+
+// The values of every name:index variable with the same name
+typedef struct DenseArrayStruct {
+    int * values; // The values by index, anything at or past length is 0
+    unsigned int length; // How many values have been given room
+    unsigned int capacity; // How many values there is room for
+} denseArray;
+
+// The call stack is limited by how much memory its frames use rather than by how deep it is
+#define DEFAULT_MEMORY_BUDGET ((size_t)256 * 1024 * 1024)
+
+// A running instance of a module, one for each function call that hasn't returned yet
+typedef struct TASStruct {
+    Module * module; // The program being run
+	tileQueue * Activation; // The activation queue
+    int * slots; // The values of every variable without a joiner, indexed by Point slot
+    unsigned int slotCapacity; // How many slots there is room for, frames keep their slots between calls
+    denseArray * arrays; // The values of name:index variables, indexed by Point array
+    unsigned int arrayCapacity; // How many arrays there is room for, frames keep their arrays between calls
+    struct varmgr * vm; // The variable manager, only used for joiner (:) names that can't go in an array
+    size_t memory; // How much memory the frame is using, counting its arrays and variable manager as they grow
+    struct FrameStackStruct * stack; // The stack the frame is in, which counts its memory too
+
+    // For function calls
+    Call * call; // The call that started this frame, NULL for the first frame
+    int * arguments; // The values of the call's arguments, used in order by parameter input (')
+    unsigned int argumentCount; // How many arguments the call gave
+    unsigned int argumentsUsed; // How many arguments have been used
+    int * returns; // The values for the call's return holders, set in order by return values (^)
+    unsigned int returnCount; // How many return holders the call has
+    unsigned int returnsUsed; // How many return values have been set
+    unsigned int argumentCapacity; // How many arguments there is room for, kept between calls
+    unsigned int returnCapacity; // How many return values there is room for, kept between calls
+    bool memoising; // Whether the call's return values are remembered once it returns
+    unsigned long long eventsAtCall; // The instance's observableEvents when the call started
+
+} TAS;
+
+// The frames of every function call that is running
+// Frames above depth are kept so later calls can reuse them instead of allocating new ones
+typedef struct FrameStackStruct {
+    TAS ** frames; // The frames, the running one is at depth - 1
+    unsigned int depth; // How many frames are in use
+    unsigned int pooled; // How many frames have been created
+    unsigned int capacity; // How many frames there is room for
+    size_t memoryUsed; // How much memory the frames in use take up
+    size_t memoryBudget; // How much memory the frames in use may take up
+    bool overBudget; // Set as soon as a frame's variables grow past the budget, which stops the run at the next tile
+} frameStack;
+
+// How much output is kept before it is handed to the write function, unless told otherwise
+#define DEFAULT_OUTPUT_BUFFER_SIZE (1 << 16)
+#define INT_DIGITS 11 // The most characters an int can take up, a minus sign and 10 digits
+
+// Output from @ $ ; and messages, kept until the flush policy says to hand it on
+typedef struct OutputSinkStruct {
+    char * text;
+    size_t length;
+    size_t capacity; // Grown past the buffer size only when the output is kept in memory or until the run stops
+    size_t size; // The buffer size from the options
+    int flushPolicy;
+} outputSink;
+
+#define INPUT_BUFFER_SIZE (1 << 16)
+#define INPUT_TOKEN_SHOWN 32 // How much of input that isn't an integer is shown in the error
+
+// Gives " tiles the integers in a file descriptor, separated by whitespace, or the values of an array in memory
+typedef struct InputReaderStruct {
+    int file;
+    char * buffer; // Allocated the first time the file is read
+    size_t length;
+    size_t position;
+    const int * values; // Used instead of the file when it isn't NULL
+    size_t valueCount;
+    size_t valuesUsed;
+    char token [INPUT_TOKEN_SHOWN + 1]; // The start of the last piece of input that wasn't an integer
+} inputReader;
+
+// Everything one run of a program uses, nothing is shared with other instances except the program
+struct TasInstanceStruct {
+    tasProgram * program;
+    tasOptions options;
+    frameStack stack; // Kept between runs so their frames can be reused
+    TAS * leafFrame; // Used by every call to a leaf module, which runs to its end without going on the stack, NULL until the first one
+    frameStack leafStack; // Counts the leaf frame's memory on top of the frames in use, without adding to them
+
+    // The results of calls to pure modules, NULL when calls aren't memoised
+    memoCache * pureCalls;
+    // Counts everything the program does that can be seen from outside, input, output and missing parameter messages
+    // A call to a pure module is only remembered if this didn't change while it ran
+    unsigned long long observableEvents;
+
+    tasReadFunction read;
+    void * readContext;
+    inputReader reader; // Used when input comes from a file descriptor or an array
+    unsigned long long inputsRead; // How many values " tiles have read in the run, for pointing out bad input
+    tasWriteFunction write; // NULL when output is kept in memory
+    void * writeContext;
+    outputSink output;
+    int lastInput; // The value " tiles use once there is no more input
+
+    unsigned long long cycles; // How many cycles the run has taken so far
+    int result; // TAS_RUNNING or TAS_WAITING while a run can be resumed, otherwise TAS_OK or the error the last run stopped with
+    char message [256]; // What the error was
+};
+
+// Prototypes
+static Module * getModule(tasProgram * program, const char * path);
+static TAS * pushFrame(tasInstance * instance, Module * module, Call * call, unsigned int argumentCount, unsigned int returnCount);
+static TAS * MakeTAS();
+static void startTAS(TAS * tas, Module * module, Call * call, unsigned int argumentCount, unsigned int returnCount);
+static void freeTAS(TAS * tas);
+static unsigned long long runLoop(tasInstance * instance, TAS * tas, unsigned int index, Instruction * compare, unsigned long long remaining);
+
+// Builds the full variable name of a joiner point into buffer
+// i.e. arr:i becomes arr:17 when i is 17
+// buffer must have room for baseLength + joinCount * 12 + 1 characters
+static void joinPointName(TAS * tas, Point * point, char * buffer){
+    memcpy(buffer, point->name, point->baseLength);
+    unsigned int length = point->baseLength;
+    for (unsigned int i = 0; i < point->joinCount; i++){
+        int value = point->joinSlots[i] == -1 ? 0 : tas->slots[point->joinSlots[i]];
+        length += sprintf(buffer + length, ":%d", value);
+    }
+    buffer[length] = '\0';
+}
+
+// Returns the index of a point with a dense array, or -1 if the index is outside of what arrays are kept for
+static int denseIndex(TAS * tas, Point * point){
+    int index = point->joinSlots[0] == -1 ? 0 : tas->slots[point->joinSlots[0]];
+    return (index >= 0 && index < MAX_DENSE_INDEX) ? index : -1;
+}
+
+// Counts memory a frame has taken up since it was started, noting when it takes the frames over the memory budget
+static void trackGrowth(TAS * tas, size_t grown){
+    tas->memory += grown;
+    tas->stack->memoryUsed += grown;
+    if (tas->stack->memoryUsed > tas->stack->memoryBudget){
+        tas->stack->overBudget = true;
+    }
+}
+
+// How much memory a variable manager is using
+static size_t varMemory(struct varmgr * vm){
+    return sizeof(var) * vm->size + vm->namesCapacity;
+}
+
+// Returns where the value of a point with a dense array is stored, growing the array to fit it
+static int * denseElement(TAS * tas, Point * point, int index){
+    denseArray * array = &tas->arrays[point->array];
+    if ((unsigned int)index >= array->length){
+        if ((unsigned int)index >= array->capacity){
+            unsigned int capacity = array->capacity == 0 ? 16 : array->capacity;
+            while (capacity <= (unsigned int)index){
+                capacity *= 2;
+            }
+            array->values = realloc(array->values, sizeof(int) * capacity);
+            trackGrowth(tas, sizeof(int) * (capacity - array->capacity));
+            array->capacity = capacity;
+        }
+        // Everything between the old length and index reads as 0
+        memset(array->values + array->length, 0, sizeof(int) * (index + 1 - array->length));
+        array->length = index + 1;
+    }
+    return &array->values[index];
+}
+
+// Returns the value of the variable a point refers to
+static int getPointValue(TAS * tas, Point * point){
+    if (point->slot != -1){
+        return tas->slots[point->slot];
+    }
+    if (point->array != -1){
+        int index = denseIndex(tas, point);
+        if (index != -1){
+            denseArray * array = &tas->arrays[point->array];
+            return (unsigned int)index < array->length ? array->values[index] : 0;
+        }
+    }
+    char name [point->baseLength + point->joinCount * 12 + 1];
+    joinPointName(tas, point, name);
+    return tasGetVar(name, tas->vm);
+}
+
+// Sets the value of the variable a point refers to
+static void setPointValue(TAS * tas, Point * point, int value){
+    if (point->slot != -1){
+        tas->slots[point->slot] = value;
+        return;
+    }
+    if (point->array != -1){
+        int index = denseIndex(tas, point);
+        if (index != -1){
+            *denseElement(tas, point, index) = value;
+            return;
+        }
+    }
+    char name [point->baseLength + point->joinCount * 12 + 1];
+    joinPointName(tas, point, name);
+    size_t before = varMemory(tas->vm);
+    tasSetVar(name, value, tas->vm);
+    trackGrowth(tas, varMemory(tas->vm) - before);
+}
+
+// Increments or decrements the variable a point refers to by 1
+static void changePointValue(TAS * tas, Point * point, bool direction){
+    if (point->slot != -1){
+        tas->slots[point->slot] += direction ? 1 : -1;
+        return;
+    }
+    if (point->array != -1){
+        int index = denseIndex(tas, point);
+        if (index != -1){
+            *denseElement(tas, point, index) += direction ? 1 : -1;
+            return;
+        }
+    }
+    char name [point->baseLength + point->joinCount * 12 + 1];
+    joinPointName(tas, point, name);
+    size_t before = varMemory(tas->vm);
+    tasChangeVar(name, direction, tas->vm);
+    trackGrowth(tas, varMemory(tas->vm) - before);
+}
+
+// Removes the variable a point refers to, it will read as 0 afterwards
+static void removePointValue(TAS * tas, Point * point){
+    if (point->slot != -1){
+        tas->slots[point->slot] = 0;
+        return;
+    }
+    if (point->array != -1){
+        int index = denseIndex(tas, point);
+        if (index != -1){
+            denseArray * array = &tas->arrays[point->array];
+            if ((unsigned int)index < array->length){
+                array->values[index] = 0;
+            }
+            return;
+        }
+    }
+    char name [point->baseLength + point->joinCount * 12 + 1];
+    joinPointName(tas, point, name);
+    tasRemoveVar(name, tas->vm);
+}
+
+// Whether an entry in the ring is for a tile that is still queued
+static bool isLiveEntry(tileQueue * activationQueue, queuedTile entry){
+    return activationQueue->queued[entry.index] && activationQueue->generations[entry.index] == entry.generation;
+}
+
+// Makes sure the ring has room for extra more entries
+// Stale entries are dropped first, and the ring only grows if it would still be more than half full
+static void reserveActivationQueue(tileQueue * activationQueue, unsigned int extra){
+    if (activationQueue->count + extra <= activationQueue->capacity){
+        return;
+    }
+
+    unsigned int capacity = activationQueue->capacity;
+    while ((activationQueue->live + extra) * 2 > capacity){
+        capacity *= 2;
+    }
+
+    queuedTile * ring = malloc(sizeof(queuedTile) * capacity);
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < activationQueue->count; i++){
+        queuedTile entry = activationQueue->ring[(activationQueue->head + i) & (activationQueue->capacity - 1)];
+        if (isLiveEntry(activationQueue, entry)){
+            ring[count] = entry;
+            count++;
+        }
+    }
+
+    free(activationQueue->ring);
+    activationQueue->ring = ring;
+    activationQueue->capacity = capacity;
+    activationQueue->head = 0;
+    activationQueue->count = count;
+}
+
+// Adds a tile to the end of the activation queue (FIFO)
+static void activate(tileQueue * activationQueue, unsigned int index){
+    if (activationQueue->queued[index]){
+        return;
+    }
+    activationQueue->queued[index] = true;
+
+    reserveActivationQueue(activationQueue, 1);
+    queuedTile * entry = &activationQueue->ring[(activationQueue->head + activationQueue->count) & (activationQueue->capacity - 1)];
+    entry->index = index;
+    entry->generation = activationQueue->generations[index];
+    activationQueue->count++;
+    activationQueue->live++;
+}
+
+// Adds the tiles from start up to but not including end to the activation queue, moving in direction
+// Room is made for the whole range at once so the tiles can be written straight into the ring
+static void activateRange(tileQueue * activationQueue, int start, int end, int direction){
+    reserveActivationQueue(activationQueue, (unsigned int)abs(end - start));
+
+    unsigned int mask = activationQueue->capacity - 1;
+    unsigned int tail = activationQueue->head + activationQueue->count;
+    unsigned int added = 0;
+    for (int i = start; i != end; i += direction){
+        if (!activationQueue->queued[i]){
+            activationQueue->queued[i] = true;
+            activationQueue->ring[(tail + added) & mask].index = i;
+            activationQueue->ring[(tail + added) & mask].generation = activationQueue->generations[i];
+            added++;
+        }
+    }
+    activationQueue->count += added;
+    activationQueue->live += added;
+}
+
+// Removes a tile from the activation queue
+// This is used when a tile is deactivated, its entry is left in the ring and skipped later
+static void deactivate(tileQueue * activationQueue, unsigned int index){
+    if (!activationQueue->queued[index]){
+        return;
+    }
+    activationQueue->queued[index] = false;
+    activationQueue->generations[index]++;
+    activationQueue->live--;
+}
+
+// Takes the first tile off the activation queue and returns its index
+// There must be at least one tile queued
+static unsigned int nextActivation(tileQueue * activationQueue){
+    for (;;){
+        queuedTile entry = activationQueue->ring[activationQueue->head];
+        activationQueue->head = (activationQueue->head + 1) & (activationQueue->capacity - 1);
+        activationQueue->count--;
+        if (isLiveEntry(activationQueue, entry)){
+            activationQueue->queued[entry.index] = false;
+            activationQueue->live--;
+            return entry.index;
+        }
+    }
+}
+
+// Puts a tile that was just taken off the activation queue back at the front, so it is the next one taken
+static void requeueActivation(tileQueue * activationQueue, unsigned int index){
+    activationQueue->head = (activationQueue->head - 1) & (activationQueue->capacity - 1);
+    activationQueue->ring[activationQueue->head].index = index;
+    activationQueue->ring[activationQueue->head].generation = activationQueue->generations[index];
+    activationQueue->queued[index] = true;
+    activationQueue->count++;
+    activationQueue->live++;
+}
+
+// Removes the tiles from start up to but not including end from the activation queue, moving in direction
+static void deactivateRange(tileQueue * activationQueue, int start, int end, int direction){
+    for (int i = start; i != end; i += direction){
+        deactivate(activationQueue, i);
+    }
+}
+
+static int operandValue(TAS * tas, Operand * operand){
+    switch (operand->kind){
+        case OPERAND_SLOT:
+            return tas->slots[operand->value];
+        case OPERAND_POINT:
+            return getPointValue(tas, operand->point);
+        default:
+            return operand->value;
+    }
+}
+
+// Returns whether there is a program to load at a path, either as text or as a binary image
+static bool moduleExists(char * filename){
+    // Checking if the file exists by trying to open it
+    FILE *file = fopen(filename, "r");
+    if (file == NULL){
+        char imageName [strlen(filename) + 2];
+        strcpy(imageName, filename);
+        strcat(imageName, "b");
+        file = fopen(imageName, "r");
+    }
+    if (file == NULL){
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+// Links every function call in a module to what it runs, loading the modules it calls
+// A file in the current folder always wins, then a native version, and then the file in the stdlib folder
+// The stdlib file is loaded even when there is a native version, so it can be run when intrinsics are turned off
+// Calls to files that don't exist are left unlinked and only stop the program if they are made
+// Returns false if a called module exists but can't be loaded
+static bool linkCalls(tasProgram * program, Module * module){
+    for (unsigned int i = 0; i < module->length; i++){
+        Call * call = module->code[i].call;
+        // Calls from a bundle were linked when it was loaded
+        if (call == NULL || call->module != NULL){
+            continue;
+        }
+
+        if (moduleExists(call->fileName)){
+            call->module = getModule(program, call->fileName);
+        } else {
+            call->intrinsic = tasFindIntrinsic(call->fileName);
+
+            // Checking inside of the stdlib folder
+            char newFilename [strlen(call->fileName) + 8];
+            strcpy(newFilename, "stdlib/");
+            strcat(newFilename, call->fileName);
+            if (!moduleExists(newFilename)){
+                continue;
+            }
+            call->module = getModule(program, newFilename);
+        }
+        if (call->module == NULL){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stops the run with an error, the message is kept for tasErrorMessage
+static void failRun(tasInstance * instance, int result, const char * message){
+    instance->result = result;
+    snprintf(instance->message, sizeof(instance->message), "%s", message);
+}
+
+// Stops the run because the read function gave something that isn't an integer
+static void failBadInput(tasInstance * instance){
+    char message [160];
+    if (instance->readContext == &instance->reader){
+        snprintf(message, sizeof(message), "Error: Input %llu, \"%s\", is not an integer from %d to %d", instance->inputsRead + 1,
+                 instance->reader.token, INT_MIN, INT_MAX);
+    } else {
+        snprintf(message, sizeof(message), "Error: Input %llu is not an integer from %d to %d", instance->inputsRead + 1,
+                 INT_MIN, INT_MAX);
+    }
+    failRun(instance, TAS_ERROR_INPUT, message);
+}
+
+// Hands the buffered output to the write function, output kept in memory stays where it is
+static void flushOutput(tasInstance * instance){
+    outputSink * output = &instance->output;
+    if (instance->write != NULL && output->length > 0){
+        instance->write(instance->writeContext, output->text, output->length);
+        output->length = 0;
+    }
+}
+
+// Makes room for length more characters of output, flushing the buffer if it is full and the policy allows it
+// Returns false if the text should go straight to the write function instead, because it is bigger than the buffer
+static bool reserveOutput(tasInstance * instance, size_t length){
+    outputSink * output = &instance->output;
+    bool keeping = instance->write == NULL || output->flushPolicy == TAS_FLUSH_EXIT;
+    if (!keeping){
+        flushOutput(instance);
+        if (length > output->capacity){
+            return false;
+        }
+        return true;
+    }
+    size_t capacity = output->capacity;
+    while (output->length + length > capacity){
+        capacity *= 2;
+    }
+    output->text = realloc(output->text, capacity);
+    output->capacity = capacity;
+    return true;
+}
+
+// Adds output to the buffer, a newline hands the buffer on straight away when flushing on newlines
+static void writeOutput(tasInstance * instance, const char * text, size_t length){
+    outputSink * output = &instance->output;
+    if (output->length + length > output->capacity && !reserveOutput(instance, length)){
+        instance->write(instance->writeContext, text, length);
+        return;
+    }
+    memcpy(output->text + output->length, text, length);
+    output->length += length;
+    if (output->flushPolicy == TAS_FLUSH_NEWLINE && memchr(text, '\n', length) != NULL){
+        flushOutput(instance);
+    }
+}
+
+// Adds one character of output, the common case of $ and ; is kept short
+static void writeOutputChar(tasInstance * instance, char character){
+    outputSink * output = &instance->output;
+    if (output->length == output->capacity){
+        reserveOutput(instance, 1);
+    }
+    output->text[output->length] = character;
+    output->length++;
+    if (character == '\n' && output->flushPolicy == TAS_FLUSH_NEWLINE){
+        flushOutput(instance);
+    }
+}
+
+// Adds an int in decimal to the output, written straight into the buffer
+static void writeOutputInt(tasInstance * instance, int value){
+    outputSink * output = &instance->output;
+    if (output->length + INT_DIGITS > output->capacity){
+        reserveOutput(instance, INT_DIGITS);
+    }
+    // Working with the magnitude as unsigned so INT_MIN doesn't overflow
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    char digits [INT_DIGITS];
+    unsigned int count = 0;
+    do {
+        digits[count] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+        count++;
+    } while (magnitude > 0);
+
+    char * text = output->text + output->length;
+    if (value < 0){
+        *text = '-';
+        text++;
+    }
+    for (unsigned int i = 0; i < count; i++){
+        text[i] = digits[count - 1 - i];
+    }
+    output->length = (size_t)(text + count - output->text);
+}
+
+// Printed by ' tiles, and native versions of functions, that have no argument left to use
+static void writeMissingParameter(tasInstance * instance){
+    const char message [] = "Variable is being set to 0 because there are no more parameters\n";
+    writeOutput(instance, message, sizeof(message) - 1);
+    instance->observableEvents++;
+}
+
+// Runs a call to a native version of a function straight away, with no frame
+static void runIntrinsic(tasInstance * instance, TAS * tas, Call * call){
+    int arguments [call->argumentCount + 1];
+    int returns [call->returnHolderCount + 1];
+    for (unsigned int i = 0; i < call->argumentCount; i++){
+        arguments[i] = getPointValue(tas, call->arguments[i]);
+    }
+    memset(returns, 0, sizeof(int) * call->returnHolderCount);
+    // The TAS version reads all of its parameters before anything else, so the messages come first
+    for (unsigned int i = call->argumentCount; i < call->intrinsic->parameterCount; i++){
+        writeMissingParameter(instance);
+    }
+
+    call->intrinsic->run(arguments, call->argumentCount, returns, call->returnHolderCount);
+    for (unsigned int i = 0; i < call->returnHolderCount; i++){
+        setPointValue(tas, call->returnHolders[i], returns[i]);
+    }
+}
+
+// Runs a call to a leaf module straight away in the instance's leaf frame, which is never pushed, so there is no frame to set up or pop
+// Nothing a leaf module does can be seen from outside, so if it can't finish within remaining cycles, goes over the memory
+// budget, or runs out of parameters it is dropped and false is returned for the call to be made with a frame instead
+// Otherwise its return values are left in the leaf frame and the cycles its tiles took are added to cycles
+static bool runLeaf(tasInstance * instance, Call * call, const int * arguments, unsigned long long remaining, unsigned long long * cycles){
+    frameStack * leafStack = &instance->leafStack;
+    if (instance->leafFrame == NULL){
+        instance->leafFrame = MakeTAS();
+        instance->leafFrame->stack = leafStack;
+    }
+    TAS * leaf = instance->leafFrame;
+    startTAS(leaf, call->module, call, call->argumentCount, call->returnHolderCount);
+    leafStack->memoryBudget = instance->stack.memoryBudget;
+    leafStack->memoryUsed = instance->stack.memoryUsed + leaf->memory;
+    leafStack->overBudget = false;
+    if (leafStack->memoryUsed > leafStack->memoryBudget){
+        return false;
+    }
+    if (call->argumentCount > 0){
+        memcpy(leaf->arguments, arguments, sizeof(int) * call->argumentCount);
+    }
+
+    unsigned long long used = 0;
+    while (leaf->Activation->live > 0){
+        if (used == remaining || leafStack->overBudget){
+            return false;
+        }
+        unsigned int index = nextActivation(leaf->Activation);
+        Instruction * instruction = &call->module->code[index];
+        used++;
+
+        switch (instruction->op){
+            case OP_NOP:
+                break;
+            case OP_ACTIVATE_RIGHT:
+                activateRange(leaf->Activation, index + 1, instruction->rightEnd, 1);
+                break;
+            case OP_ACTIVATE_LEFT:
+                activateRange(leaf->Activation, (int)index - 1, instruction->leftEnd, -1);
+                break;
+            case OP_POKE:
+            case OP_REMOTE:
+                activate(leaf->Activation, instruction->target);
+                break;
+            case OP_DEACTIVATE_LEFT:
+                deactivateRange(leaf->Activation, (int)index - 1, instruction->leftEnd, -1);
+                break;
+            case OP_DEACTIVATE_RIGHT:
+                deactivateRange(leaf->Activation, index + 1, instruction->rightEnd, 1);
+                break;
+            case OP_COMPARE:
+                if (instruction->loop != NULL && instance->options.accelerateLoops && leaf->Activation->live == 0){
+                    used += runLoop(instance, leaf, index, instruction, remaining - used);
+                }
+                if (operandValue(leaf, &instruction->right) > operandValue(leaf, &instruction->left)){
+                    activateRange(leaf->Activation, index + 1, instruction->rightEnd, 1);
+                } else {
+                    activateRange(leaf->Activation, (int)index - 1, instruction->leftEnd, -1);
+                }
+                break;
+            case OP_ASSIGN:
+                setPointValue(leaf, instruction->point, operandValue(leaf, &instruction->left) + operandValue(leaf, &instruction->right));
+                break;
+            case OP_INCREMENT:
+                changePointValue(leaf, instruction->point, true);
+                break;
+            case OP_DECREMENT:
+                changePointValue(leaf, instruction->point, false);
+                break;
+            case OP_PARAMETER:
+                if (leaf->argumentsUsed == leaf->argumentCount){
+                    // Leaving the message to the frame
+                    return false;
+                }
+                setPointValue(leaf, instruction->point, leaf->arguments[leaf->argumentsUsed]);
+                leaf->argumentsUsed++;
+                break;
+            case OP_DESTROY:
+                removePointValue(leaf, instruction->point);
+                break;
+            case OP_RETURN:
+                if (leaf->returnsUsed < leaf->returnCount){
+                    leaf->returns[leaf->returnsUsed] = getPointValue(leaf, instruction->point);
+                    leaf->returnsUsed++;
+                }
+                break;
+            default:
+                // Only input, output and calls are left, which leaf modules don't have
+                return false;
+        }
+    }
+    if (leafStack->overBudget){
+        return false;
+    }
+    *cycles += used;
+    return true;
+}
+
+// Starts a function call instruction by pushing a frame for the called module, or runs its native version
+// The arguments are read now, and the return holders are set once the frame returns
+// Calls to pure modules that were made before with the same arguments are answered from pureCalls instead,
+// and calls to leaf modules that fit in the cycles left before limit are run straight away, adding their cycles to cycles
+// Returns the new running frame, which is still the caller's for native versions, remembered calls and leaf calls,
+// or NULL if the call can't be made
+static TAS * callFunction(tasInstance * instance, TAS * tas, Call * call, unsigned long long * cycles, unsigned long long limit){
+    if (call->intrinsic != NULL && instance->options.useIntrinsics){
+        runIntrinsic(instance, tas, call);
+        return tas;
+    }
+    if (call->module == NULL){
+        char message [strlen(call->fileName) + 32];
+        sprintf(message, "File %s does not exist", call->fileName);
+        failRun(instance, TAS_ERROR_MISSING_CALL, message);
+        return NULL;
+    }
+
+    bool memoising = instance->pureCalls != NULL && call->module->pure;
+    if (memoising || (call->module->leaf && instance->options.runLeaves)){
+        int arguments [call->argumentCount + 1];
+        int returns [call->returnHolderCount + 1];
+        for (unsigned int i = 0; i < call->argumentCount; i++){
+            arguments[i] = getPointValue(tas, call->arguments[i]);
+        }
+        if (memoising && tasFindMemo(instance->pureCalls, call->module, arguments, call->argumentCount, returns, call->returnHolderCount)){
+            for (unsigned int i = 0; i < call->returnHolderCount; i++){
+                setPointValue(tas, call->returnHolders[i], returns[i]);
+            }
+            return tas;
+        }
+
+        if (call->module->leaf && instance->options.runLeaves && runLeaf(instance, call, arguments, limit - *cycles, cycles)){
+            TAS * leaf = instance->leafFrame;
+            if (memoising){
+                tasStoreMemo(instance->pureCalls, call->module, arguments, call->argumentCount, leaf->returns, call->returnHolderCount);
+            }
+            for (unsigned int i = 0; i < call->returnHolderCount; i++){
+                setPointValue(tas, call->returnHolders[i], leaf->returns[i]);
+            }
+            return tas;
+        }
+
+        TAS * callee = pushFrame(instance, call->module, call, call->argumentCount, call->returnHolderCount);
+        if (callee == NULL){
+            return NULL;
+        }
+        if (call->argumentCount > 0){
+            memcpy(callee->arguments, arguments, sizeof(int) * call->argumentCount);
+        }
+        callee->memoising = memoising;
+        callee->eventsAtCall = instance->observableEvents;
+        return callee;
+    }
+
+    TAS * callee = pushFrame(instance, call->module, call, call->argumentCount, call->returnHolderCount);
+    if (callee == NULL){
+        return NULL;
+    }
+    for (unsigned int i = 0; i < call->argumentCount; i++){
+        callee->arguments[i] = getPointValue(tas, call->arguments[i]);
+    }
+    return callee;
+}
+
+// Pops the running frame once its activation queue is empty, using its return values to set the caller's return holders
+// Return holders that were never given a value are set to 0
+// Returns the caller's frame, which runs again from where it was
+static TAS * returnFromFunction(tasInstance * instance){
+    frameStack * stack = &instance->stack;
+    TAS * callee = stack->frames[stack->depth - 1];
+    TAS * caller = stack->frames[stack->depth - 2];
+
+    // Only remembering calls that did nothing visible, a pure module can still reach a message or an impure call
+    if (callee->memoising && instance->observableEvents == callee->eventsAtCall){
+        tasStoreMemo(instance->pureCalls, callee->module, callee->arguments, callee->argumentCount, callee->returns, callee->returnCount);
+    }
+
+    for (unsigned int i = 0; i < callee->returnCount; i++){
+        setPointValue(caller, callee->call->returnHolders[i], callee->returns[i]);
+    }
+
+    stack->memoryUsed -= callee->memory;
+    stack->depth--;
+    return caller;
+}
+
+// Sets result to a * b for two affine maps of the given width, wrapping like the interpreter
+static void multiplyTransforms(unsigned int * a, unsigned int * b, unsigned int * result, unsigned int width){
+    for (unsigned int r = 0; r < width; r++){
+        for (unsigned int c = 0; c < width; c++){
+            unsigned int sum = 0;
+            for (unsigned int k = 0; k < width; k++){
+                sum += a[r * width + k] * b[k * width + c];
+            }
+            result[r * width + c] = sum;
+        }
+    }
+}
+
+// Applies a loop's map to its variables the given number of times, squaring the map to need only log(iterations) steps
+static void applyLoopTransform(TAS * tas, Loop * loop, unsigned long long iterations){
+    unsigned int width = loop->slotCount + 1;
+    unsigned int values [width];
+    unsigned int next [width];
+    unsigned int power [width * width];
+    unsigned int squared [width * width];
+    for (unsigned int r = 0; r < loop->slotCount; r++){
+        values[r] = (unsigned int)tas->slots[loop->slots[r]];
+    }
+    values[loop->slotCount] = 1;
+    memcpy(power, loop->transform, sizeof(power));
+
+    while (iterations > 0){
+        if (iterations & 1){
+            for (unsigned int r = 0; r < width; r++){
+                unsigned int sum = 0;
+                for (unsigned int c = 0; c < width; c++){
+                    sum += power[r * width + c] * values[c];
+                }
+                next[r] = sum;
+            }
+            memcpy(values, next, sizeof(values));
+        }
+        iterations >>= 1;
+        if (iterations > 0){
+            multiplyTransforms(power, power, squared, width);
+            memcpy(power, squared, sizeof(power));
+        }
+    }
+
+    for (unsigned int r = 0; r < loop->slotCount; r++){
+        tas->slots[loop->slots[r]] = (int)values[r];
+    }
+}
+
+// Works out how many more times a counted loop will go round, returns -1 if the counter would wrap before it stops
+static long long countLoopIterations(TAS * tas, Instruction * compare){
+    Loop * loop = compare->loop;
+    long long counter = tas->slots[loop->slots[loop->counter]];
+    long long fixed = operandValue(tas, loop->counterOnRight ? &compare->left : &compare->right);
+    long long distance = loop->counterOnRight ? counter - fixed : fixed - counter; // The loop goes round while this is above 0
+    if (distance <= 0){
+        return 0;
+    }
+
+    long long stepSize = loop->step < 0 ? -(long long)loop->step : loop->step;
+    long long iterations = (distance + stepSize - 1) / stepSize;
+    long long last = counter + iterations * loop->step;
+    if (last < INT_MIN || last > INT_MAX){
+        return -1;
+    }
+    return iterations;
+}
+
+// Runs the iterations of a loop found when compiling at once, leaving the ? to make its next comparison as normal
+// Only done when the ? is the only tile activated, so nothing else could have run between the iterations
+// Each iteration counts as the cycles its tiles and the ? would have taken, and no more iterations are run than fit in
+// remaining cycles, so the loop carries on tile by tile from the ? when the quantum or the cycle budget runs out
+// Returns the number of cycles the iterations took
+static unsigned long long runLoop(tasInstance * instance, TAS * tas, unsigned int index, Instruction * compare, unsigned long long remaining){
+    Loop * loop = compare->loop;
+    unsigned long long iterationCycles = (unsigned long long)loop->tileCount + 1;
+    unsigned long long allowed = remaining / iterationCycles;
+    long long iterations = loop->counter != -1 ? countLoopIterations(tas, compare) : -1;
+    bool closedForm = iterations != -1;
+
+    if (closedForm){
+        if ((unsigned long long)iterations > allowed){
+            iterations = (long long)allowed;
+        }
+        applyLoopTransform(tas, loop, (unsigned long long)iterations);
+    } else {
+        // Going round one iteration at a time, but without going through the activation queue
+        iterations = 0;
+        while ((unsigned long long)iterations < allowed && operandValue(tas, &compare->right) > operandValue(tas, &compare->left)){
+            for (unsigned int i = 0; i < loop->stepCount; i++){
+                LoopStep * step = &loop->steps[i];
+                if (step->op == OP_ASSIGN){
+                    tas->slots[step->slot] = (int)((unsigned int)operandValue(tas, &step->left) + (unsigned int)operandValue(tas, &step->right));
+                } else {
+                    tas->slots[step->slot] = (int)((unsigned int)tas->slots[step->slot] + (step->op == OP_INCREMENT ? 1u : (unsigned int)-1));
+                }
+            }
+            iterations++;
+        }
+    }
+
+    if (instance->options.traceLoops && iterations > 0){
+        char trace [strlen(tas->module->path) + 96];
+        int length = sprintf(trace, "[loop] %s tile %u: %lld iterations of %u tiles %s\n", tas->module->path, index, iterations,
+                             loop->tileCount, closedForm ? "in closed form" : "natively");
+        writeOutput(instance, trace, (size_t)length);
+    }
+    return (unsigned long long)iterations * iterationCycles;
+}
+
+// Uses computed gotos for dispatching where the compiler supports them, otherwise a switch
+#if defined(__GNUC__)
+#define TAS_COMPUTED_GOTO
+#endif
+
+#ifdef TAS_COMPUTED_GOTO
+#define CASE(op) label_##op:
+#else
+#define CASE(op) case op:
+#endif
+
+// Stops the run because a frame's variables grew past the memory budget
+static void failMemoryBudget(tasInstance * instance){
+    char message [128];
+    sprintf(message, "Error: The program went over its memory budget of %zu bytes", instance->stack.memoryBudget);
+    failRun(instance, TAS_ERROR_MEMORY, message);
+}
+
+// Runs the instructions of the tiles in the activation queue of the running frame until the first frame's queue is empty
+// or limit cycles have been run
+// Function calls push a frame and keep going in the loop, and a frame returns once its queue is empty
+// Returns the number of cycles that were run, a call that can't be made, a " tile that has to wait for input or going over
+// the memory budget stops it early with the instance's result set
+static unsigned long long runCycles(tasInstance * instance, unsigned long long limit){
+#ifdef TAS_COMPUTED_GOTO
+    static void * dispatch [OP_COUNT] = {
+        &&label_OP_NOP, &&label_OP_ACTIVATE_RIGHT, &&label_OP_ACTIVATE_LEFT, &&label_OP_POKE,
+        &&label_OP_DEACTIVATE_LEFT, &&label_OP_DEACTIVATE_RIGHT, &&label_OP_REMOTE, &&label_OP_COMPARE, &&label_OP_ASSIGN,
+        &&label_OP_INCREMENT, &&label_OP_DECREMENT, &&label_OP_INPUT, &&label_OP_PARAMETER,
+        &&label_OP_DESTROY, &&label_OP_CALL, &&label_OP_OUTPUT_INT, &&label_OP_RETURN,
+        &&label_OP_OUTPUT_CHAR, &&label_OP_NEWLINE
+    };
+#endif
+    unsigned long long cycles = 0;
+    frameStack * stack = &instance->stack;
+    TAS * tas = stack->frames[stack->depth - 1];
+    int input;
+
+    while (cycles < limit){
+        // Returning from every function that has finished
+        while (tas->Activation->live == 0 && stack->depth > 1){
+            tas = returnFromFunction(instance);
+        }
+        if (tas->Activation->live == 0 || stack->overBudget){
+            break;
+        }
+
+        // Removing the first tile from the activation queue
+        unsigned int index = nextActivation(tas->Activation);
+        Instruction * instruction = &tas->module->code[index];
+        cycles++;
+
+#ifdef TAS_COMPUTED_GOTO
+        goto *dispatch[instruction->op];
+#else
+        switch (instruction->op){
+#endif
+        CASE(OP_NOP)
+            continue;
+        CASE(OP_ACTIVATE_RIGHT)
+            activateRange(tas->Activation, index + 1, instruction->rightEnd, 1);
+            continue;
+        CASE(OP_ACTIVATE_LEFT)
+            activateRange(tas->Activation, (int)index - 1, instruction->leftEnd, -1);
+            continue;
+        CASE(OP_POKE)
+            activate(tas->Activation, instruction->target);
+            continue;
+        CASE(OP_DEACTIVATE_LEFT)
+            deactivateRange(tas->Activation, (int)index - 1, instruction->leftEnd, -1);
+            continue;
+        CASE(OP_DEACTIVATE_RIGHT)
+            deactivateRange(tas->Activation, index + 1, instruction->rightEnd, 1);
+            continue;
+        CASE(OP_REMOTE)
+            // Activates the tile based on the index of its point from previous linking
+            activate(tas->Activation, instruction->target);
+            continue;
+        CASE(OP_COMPARE)
+            if (instruction->loop != NULL && instance->options.accelerateLoops && tas->Activation->live == 0){
+                cycles += runLoop(instance, tas, index, instruction, limit - cycles);
+            }
+            // Comparing right to left and then activating in that direction
+            // If they are equal it activates to the left i.e. left is default
+            if (operandValue(tas, &instruction->right) > operandValue(tas, &instruction->left)){
+                activateRange(tas->Activation, index + 1, instruction->rightEnd, 1);
+            } else {
+                activateRange(tas->Activation, (int)index - 1, instruction->leftEnd, -1);
+            }
+            continue;
+        CASE(OP_ASSIGN)
+            setPointValue(tas, instruction->point, operandValue(tas, &instruction->left) + operandValue(tas, &instruction->right));
+            continue;
+        CASE(OP_INCREMENT)
+            changePointValue(tas, instruction->point, true);
+            continue;
+        CASE(OP_DECREMENT)
+            changePointValue(tas, instruction->point, false);
+            continue;
+        CASE(OP_INPUT)
+            // Collect an integer input from the user and set the value of the variable to that
+            if (instance->output.flushPolicy == TAS_FLUSH_NEWLINE){
+                // Showing a prompt that doesn't end in a newline before waiting for the answer
+                flushOutput(instance);
+            }
+            switch (instance->read(instance->readContext, &input)){
+                case TAS_INPUT_READ:
+                    instance->lastInput = input;
+                    instance->inputsRead++;
+                    break;
+                case TAS_INPUT_WAIT:
+                    // Stopping until there is input, the tile runs again first when the run is resumed
+                    requeueActivation(tas->Activation, index);
+                    instance->result = TAS_WAITING;
+                    return cycles - 1;
+                case TAS_INPUT_ERROR:
+                    failBadInput(instance);
+                    return cycles;
+            }
+            instance->observableEvents++;
+            setPointValue(tas, instruction->point, instance->lastInput);
+            continue;
+        CASE(OP_PARAMETER)
+            // Using the next argument as the value of the variable
+            // If there are no more arguments, it will use 0
+            if (tas->argumentsUsed < tas->argumentCount){
+                setPointValue(tas, instruction->point, tas->arguments[tas->argumentsUsed]);
+                tas->argumentsUsed++;
+            } else {
+                writeMissingParameter(instance);
+                setPointValue(tas, instruction->point, 0);
+            }
+            continue;
+        CASE(OP_DESTROY)
+            removePointValue(tas, instruction->point);
+            continue;
+        CASE(OP_CALL)
+            tas = callFunction(instance, tas, instruction->call, &cycles, limit);
+            if (tas == NULL){
+                return cycles;
+            }
+            continue;
+        CASE(OP_OUTPUT_INT)
+            writeOutputInt(instance, getPointValue(tas, instruction->point));
+            instance->observableEvents++;
+            continue;
+        CASE(OP_RETURN)
+            // Setting the value of the next returnHolder to the value of this variable
+            if (tas->returnsUsed < tas->returnCount){
+                tas->returns[tas->returnsUsed] = getPointValue(tas, instruction->point);
+                tas->returnsUsed++;
+            }
+            continue;
+        CASE(OP_OUTPUT_CHAR)
+            writeOutputChar(instance, (char)getPointValue(tas, instruction->point));
+            instance->observableEvents++;
+            continue;
+        CASE(OP_NEWLINE)
+            writeOutputChar(instance, '\n');
+            instance->observableEvents++;
+            continue;
+#ifndef TAS_COMPUTED_GOTO
+        }
+#endif
+    }
+
+    // Returning from functions that finished on the last cycle
+    while (tas->Activation->live == 0 && stack->depth > 1 && !stack->overBudget){
+        tas = returnFromFunction(instance);
+    }
+    if (stack->overBudget){
+        failMemoryBudget(instance);
+    }
+    return cycles;
+}
+
+#undef CASE
+
+
+// Creates an empty activation queue for a stack with tileCount tiles
+static tileQueue * makeActivationQueue(unsigned int tileCount){
+	tileQueue * Activation = (tileQueue *)malloc(sizeof(tileQueue));
+    Activation->capacity = 16;
+    while (Activation->capacity < tileCount){
+        Activation->capacity *= 2;
+    }
+    Activation->ring = malloc(sizeof(queuedTile) * Activation->capacity);
+    Activation->head = 0;
+    Activation->count = 0;
+    Activation->live = 0;
+    Activation->tileCapacity = tileCount > 0 ? tileCount : 1;
+    Activation->queued = calloc(tileCount > 0 ? tileCount : 1, sizeof(bool));
+    Activation->generations = calloc(tileCount > 0 ? tileCount : 1, sizeof(unsigned int));
+
+	return Activation;
+}
+
+// Empties an activation queue so it can be used for a stack with tileCount tiles
+static void resetActivationQueue(tileQueue * Activation, unsigned int tileCount){
+    if (tileCount > Activation->tileCapacity){
+        Activation->tileCapacity = tileCount;
+        free(Activation->queued);
+        free(Activation->generations);
+        Activation->queued = malloc(sizeof(bool) * tileCount);
+        Activation->generations = calloc(tileCount, sizeof(unsigned int));
+    }
+    memset(Activation->queued, 0, sizeof(bool) * Activation->tileCapacity);
+    Activation->head = 0;
+    Activation->count = 0;
+    Activation->live = 0;
+    reserveActivationQueue(Activation, tileCount);
+}
+
+// Adds a loaded module to the modules that are freed along with the program, and that getModule finds by path
+static void cacheModule(tasProgram * program, const char * path, Module * module){
+    moduleCache * loadedModules = &program->modules;
+    if (loadedModules->paths == NULL){
+        loadedModules->paths = tasCreateVarMgr();
+    }
+
+    // Making room for another module
+    if (loadedModules->count == loadedModules->capacity){
+        loadedModules->capacity = loadedModules->capacity == 0 ? 4 : loadedModules->capacity * 2;
+        loadedModules->modules = realloc(loadedModules->modules, sizeof(Module *) * loadedModules->capacity);
+    }
+
+    loadedModules->modules[loadedModules->count] = module;
+    loadedModules->count++;
+    tasSetVar((char *)path, (int)loadedModules->count, loadedModules->paths);
+}
+
+// Returns the module for a file, only loading it the first time it is asked for, NULL if it can't be loaded
+static Module * getModule(tasProgram * program, const char * path){
+    moduleCache * loadedModules = &program->modules;
+    if (loadedModules->paths != NULL){
+        int index = tasGetVar((char *)path, loadedModules->paths) - 1;
+        if (index != -1){
+            return loadedModules->modules[index];
+        }
+    }
+
+    Module * module = tasLoadModule(path);
+    if (module != NULL){
+        cacheModule(program, path, module);
+    }
+    return module;
+}
+
+// Creates an empty frame, its arrays are sized when it is started
+static TAS * MakeTAS(){
+    TAS * tas = (TAS *)malloc(sizeof(TAS));
+    tas->module = NULL;
+    tas->call = NULL;
+    tas->arguments = NULL;
+    tas->returns = NULL;
+    tas->argumentCapacity = 0;
+    tas->returnCapacity = 0;
+    tas->Activation = makeActivationQueue(0); // Creating the activation queue
+    tas->slotCapacity = 0;
+    tas->slots = NULL;
+    tas->arrayCapacity = 0;
+    tas->arrays = NULL;
+    tas->vm = tasCreateVarMgr(); // Creating the variable manager
+    tas->memory = 0;
+    return tas;
+}
+
+// Prepares a frame to run a module, reusing the arrays from its last call when they are big enough
+// call is NULL for the first frame, which is given its arguments and return values by the host
+static void startTAS(TAS * tas, Module * module, Call * call, unsigned int argumentCount, unsigned int returnCount){
+    tas->module = module;
+
+    // Setting function stuff up
+    tas->call = call;
+    tas->argumentCount = argumentCount;
+    tas->returnCount = returnCount;
+    tas->argumentsUsed = 0;
+    tas->returnsUsed = 0;
+    tas->memoising = false;
+    if (tas->argumentCount > tas->argumentCapacity){
+        free(tas->arguments);
+        tas->argumentCapacity = tas->argumentCount;
+        tas->arguments = malloc(sizeof(int) * tas->argumentCapacity);
+    }
+    if (tas->returnCount > tas->returnCapacity){
+        free(tas->returns);
+        tas->returnCapacity = tas->returnCount;
+        tas->returns = malloc(sizeof(int) * tas->returnCapacity);
+    }
+    if (tas->returnCount > 0){
+        memset(tas->returns, 0, sizeof(int) * tas->returnCount);
+    }
+
+    resetActivationQueue(tas->Activation, module->length);
+    for (unsigned int i = 0; i < module->initialCount; i++){
+        activate(tas->Activation, module->initial[i]);
+    }
+
+    if (module->slotCount > tas->slotCapacity){
+        free(tas->slots);
+        tas->slotCapacity = module->slotCount;
+        tas->slots = malloc(sizeof(int) * tas->slotCapacity);
+    }
+    if (tas->slotCapacity > 0){
+        memset(tas->slots, 0, sizeof(int) * module->slotCount);
+    }
+    if (module->arrayCount > tas->arrayCapacity){
+        tas->arrays = realloc(tas->arrays, sizeof(denseArray) * module->arrayCount);
+        memset(tas->arrays + tas->arrayCapacity, 0, sizeof(denseArray) * (module->arrayCount - tas->arrayCapacity));
+        tas->arrayCapacity = module->arrayCount;
+    }
+    size_t arrayMemory = sizeof(denseArray) * tas->arrayCapacity;
+    for (unsigned int i = 0; i < tas->arrayCapacity; i++){
+        tas->arrays[i].length = 0;
+        arrayMemory += sizeof(int) * tas->arrays[i].capacity;
+    }
+    tasClearVarMgr(tas->vm);
+
+    tas->memory = sizeof(TAS) + sizeof(tileQueue) + sizeof(struct varmgr)
+            + sizeof(int) * (tas->slotCapacity + tas->argumentCapacity + tas->returnCapacity)
+            + sizeof(queuedTile) * tas->Activation->capacity
+            + (sizeof(bool) + sizeof(unsigned int)) * tas->Activation->tileCapacity
+            + sizeof(var) * tas->vm->size + tas->vm->namesCapacity
+            + arrayMemory;
+}
+
+// Pushes a frame that runs module and returns it
+// Returns NULL, stopping the run, if the frames in use would go over the memory budget
+static TAS * pushFrame(tasInstance * instance, Module * module, Call * call, unsigned int argumentCount, unsigned int returnCount){
+    frameStack * stack = &instance->stack;
+    if (stack->depth == stack->pooled){
+        // No frame to reuse, so a new one is needed
+        if (stack->pooled == stack->capacity){
+            stack->capacity = stack->capacity == 0 ? 16 : stack->capacity * 2;
+            stack->frames = realloc(stack->frames, sizeof(TAS *) * stack->capacity);
+        }
+        stack->frames[stack->pooled] = MakeTAS();
+        stack->pooled++;
+    }
+
+    TAS * tas = stack->frames[stack->depth];
+    tas->stack = stack;
+    startTAS(tas, module, call, argumentCount, returnCount);
+    if (stack->memoryUsed + tas->memory > stack->memoryBudget){
+        char message [128];
+        sprintf(message, "Error: Function calls ran out of memory after %u calls deep, the limit is %zu bytes", stack->depth, stack->memoryBudget);
+        failRun(instance, TAS_ERROR_MEMORY, message);
+        return NULL;
+    }
+    stack->memoryUsed += tas->memory;
+    stack->depth++;
+    return tas;
+}
+
+
+static void freeActivationQueue(tileQueue * aq){
+    free(aq->ring);
+    free(aq->queued);
+    free(aq->generations);
+    free(aq);
+}
+
+static void freeTAS(TAS * tas){
+    free(tas->slots);
+    for (unsigned int i = 0; i < tas->arrayCapacity; i++){
+        free(tas->arrays[i].values);
+    }
+    free(tas->arrays);
+    free(tas->arguments);
+    free(tas->returns);
+    freeActivationQueue(tas->Activation);
+    tasFreeVarMgr(tas->vm);
+    free(tas);
+}
+
+static void freeFrameStack(frameStack * stack){
+    for (unsigned int i = 0; i < stack->pooled; i++){
+        freeTAS(stack->frames[i]);
+    }
+    free(stack->frames);
+}
+
+
+// Frees every loaded module
+static void freeModuleCache(moduleCache * loadedModules){
+    for (unsigned int i = 0; i < loadedModules->count; i++){
+        tasFreeModule(loadedModules->modules[i]);
+    }
+    free(loadedModules->modules);
+    if (loadedModules->paths != NULL){
+        tasFreeVarMgr(loadedModules->paths);
+    }
+    loadedModules->paths = NULL;
+    loadedModules->modules = NULL;
+    loadedModules->count = 0;
+    loadedModules->capacity = 0;
+}
+
+
+static void showStack(TAS * tas){
+	
+	unsigned int activationNums [tas->module->length];
+	 
+	for (unsigned int i = 0; i < tas->module->length; i++){
+		activationNums[i] = 0;
+	}
+	
+
+	// Going through the queue to get activation numbers
+    tileQueue * activationQueue = tas->Activation;
+	unsigned int num = 1;
+    for (unsigned int i = 0; i < activationQueue->count; i++){
+        queuedTile entry = activationQueue->ring[(activationQueue->head + i) & (activationQueue->capacity - 1)];
+        if (isLiveEntry(activationQueue, entry)){
+            activationNums[entry.index] = num;
+            num++;
+        }
+    }
+
+	// Displaying the tiles
+    printf("%4s | %2c | %5s | %10s | %5s | %s\n", "Loc", 'T', "Act", "Point", "PVal", "Address");
+    puts("--------------------------------------------------");
+	for (unsigned int i = 0; i < tas->module->length; i++){
+        Point * point = tasTilePoint(tas->module, i);
+		printf("%4u | %2c | %5u | %10s | %5d | %p\n",
+				i,
+				tas->module->types[i],
+				activationNums[i],
+                point->name,
+                getPointValue(tas, point),
+				(void *)point);
+	}
+}
+
+
+// Links the calls of every module in the program, including the modules loaded while doing so
+// Returns the program, or NULL with it freed if a called module can't be loaded
+static tasProgram * linkProgram(tasProgram * program, int * result){
+    for (unsigned int i = 0; i < program->modules.count; i++){
+        if (!linkCalls(program, program->modules.modules[i])){
+            tasFreeProgram(program);
+            *result = TAS_ERROR_LINK;
+            return NULL;
+        }
+    }
+    *result = TAS_OK;
+    return program;
+}
+
+// Makes a program with no modules
+static tasProgram * makeProgram(){
+    tasProgram * program = malloc(sizeof(tasProgram));
+    program->main = NULL;
+    program->modules = (moduleCache){NULL, NULL, 0, 0};
+    return program;
+}
+
+tasProgram * tasLoadProgram(const char * path, int * result){
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".tas") == 0){
+        // Preprocessing .tas source in memory, with no .ptas file written
+        FILE * file = fopen(path, "r");
+        char * source = tasReadSource(file, &length);
+        if (file != NULL){
+            fclose(file);
+        }
+        if (source == NULL){
+            *result = TAS_ERROR_FILE;
+            return NULL;
+        }
+        tasProgram * program = tasLoadSource(path, source, length, result);
+        free(source);
+        return program;
+    }
+
+    if (!moduleExists((char *)path)){
+        *result = TAS_ERROR_FILE;
+        return NULL;
+    }
+    tasProgram * program = makeProgram();
+    program->main = getModule(program, path);
+    if (program->main == NULL){
+        tasFreeProgram(program);
+        *result = TAS_ERROR_LINK;
+        return NULL;
+    }
+    return linkProgram(program, result);
+}
+
+tasProgram * tasLoadSource(const char * name, const char * source, size_t length, int * result){
+    size_t rawLength;
+    char * raw = tasPreprocessSource(source, length, false, &rawLength);
+    tasProgram * program = makeProgram();
+    program->main = tasLoadTextBuffer(name, raw, rawLength);
+    free(raw);
+    if (program->main == NULL){
+        tasFreeProgram(program);
+        *result = TAS_ERROR_LINK;
+        return NULL;
+    }
+    cacheModule(program, name, program->main);
+    return linkProgram(program, result);
+}
+
+void tasFreeProgram(tasProgram * program){
+    freeModuleCache(&program->modules);
+    free(program);
+}
+
+void tasDefaultOptions(tasOptions * options){
+    options->memoryBudget = DEFAULT_MEMORY_BUDGET;
+    options->cycleBudget = 0;
+    options->useIntrinsics = true;
+    options->accelerateLoops = true;
+    options->traceLoops = false;
+    options->memoise = true;
+    options->runLeaves = true;
+    options->showStack = false;
+    options->flushPolicy = TAS_FLUSH_NEWLINE;
+    options->outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE;
+}
+
+// Returns the next character of the reader's file without taking it, or EOF once the file has ended
+static int peekInput(inputReader * reader){
+    if (reader->position == reader->length){
+        if (reader->buffer == NULL){
+            reader->buffer = malloc(INPUT_BUFFER_SIZE);
+        }
+        long got;
+        do {
+            got = (long)readDescriptor(reader->file, reader->buffer, INPUT_BUFFER_SIZE);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0){
+            return EOF;
+        }
+        reader->length = (size_t)got;
+        reader->position = 0;
+    }
+    return (unsigned char)reader->buffer[reader->position];
+}
+
+// Takes the next character of the reader's file, keeping the start of the token it is part of for error messages
+static void takeInput(inputReader * reader, size_t * tokenLength){
+    if (*tokenLength < INPUT_TOKEN_SHOWN){
+        reader->token[*tokenLength] = reader->buffer[reader->position];
+        (*tokenLength)++;
+        reader->token[*tokenLength] = '\0';
+    }
+    reader->position++;
+}
+
+// Reads the next whitespace separated integer from a file descriptor
+// Anything else, or an integer too big for an int, is an error rather than the end of the input like it was with scanf
+static int readFile(void * context, int * value){
+    inputReader * reader = (inputReader *)context;
+    int character = peekInput(reader);
+    while (character != EOF && isspace(character)){
+        reader->position++;
+        character = peekInput(reader);
+    }
+    if (character == EOF){
+        return TAS_INPUT_END;
+    }
+
+    size_t tokenLength = 0;
+    bool negative = character == '-';
+    if (character == '-' || character == '+'){
+        takeInput(reader, &tokenLength);
+        character = peekInput(reader);
+    }
+    // Building the magnitude as unsigned so INT_MIN can be read, anything past it is out of range
+    unsigned int limit = negative ? (unsigned int)INT_MAX + 1 : (unsigned int)INT_MAX;
+    unsigned int magnitude = 0;
+    bool valid = character != EOF && isdigit(character);
+    while (character != EOF && isdigit(character)){
+        unsigned int digit = (unsigned int)(character - '0');
+        if (magnitude > (limit - digit) / 10){
+            valid = false;
+        }
+        magnitude = magnitude * 10 + digit;
+        takeInput(reader, &tokenLength);
+        character = peekInput(reader);
+    }
+    if (character != EOF && !isspace(character)){
+        valid = false;
+    }
+    if (!valid){
+        // Taking the rest of the token so it can be shown
+        while (character != EOF && !isspace(character)){
+            takeInput(reader, &tokenLength);
+            character = peekInput(reader);
+        }
+        return TAS_INPUT_ERROR;
+    }
+    *value = negative ? (int)(0u - magnitude) : (int)magnitude;
+    return TAS_INPUT_READ;
+}
+
+// Gives the values of an array in order
+static int readArray(void * context, int * value){
+    inputReader * reader = (inputReader *)context;
+    if (reader->valuesUsed == reader->valueCount){
+        return TAS_INPUT_END;
+    }
+    *value = reader->values[reader->valuesUsed];
+    reader->valuesUsed++;
+    return TAS_INPUT_READ;
+}
+
+// Writes output to stdout
+static void writeStdout(void * context, const char * text, size_t length){
+    (void)context;
+    fwrite(text, 1, length, stdout);
+}
+
+// Writes output to the file descriptor kept in the context, carrying on after partial writes and interrupts
+static void writeFile(void * context, const char * text, size_t length){
+    int file = (int)(intptr_t)context;
+    while (length > 0){
+        long written = (long)writeDescriptor(file, text, (unsigned int)(length < INT_MAX ? length : INT_MAX));
+        if (written < 0 && errno == EINTR){
+            continue;
+        }
+        if (written <= 0){
+            // Dropping output that can't be written, as fwrite to a closed stdout would
+            return;
+        }
+        text += written;
+        length -= (size_t)written;
+    }
+}
+
+tasInstance * tasCreateInstance(tasProgram * program, const tasOptions * options){
+    tasInstance * instance = malloc(sizeof(tasInstance));
+    instance->program = program;
+    if (options != NULL){
+        instance->options = *options;
+    } else {
+        tasDefaultOptions(&instance->options);
+    }
+    if (instance->options.showStack){
+        // Loops are run tile by tile when showing the stack so each iteration can be seen
+        instance->options.accelerateLoops = false;
+    }
+    if (instance->options.traceLoops){
+        // A leaf call that is dropped is run again with a frame, which would report its loops twice
+        instance->options.runLeaves = false;
+    }
+    instance->stack = (frameStack){NULL, 0, 0, 0, 0, instance->options.memoryBudget, false};
+    instance->leafStack = (frameStack){NULL, 0, 0, 0, 0, instance->options.memoryBudget, false};
+    instance->leafFrame = NULL;
+    instance->pureCalls = instance->options.memoise ? tasCreateMemoCache(DEFAULT_MEMO_CAPACITY) : NULL;
+    instance->observableEvents = 0;
+    instance->reader = (inputReader){0, NULL, 0, 0, NULL, 0, 0, ""};
+    instance->read = readFile;
+    instance->readContext = &instance->reader;
+    instance->write = writeStdout;
+    instance->writeContext = NULL;
+    // Leaving room for an int however small the buffer size is, so @ can always write into it
+    size_t size = instance->options.outputBufferSize > INT_DIGITS ? instance->options.outputBufferSize : INT_DIGITS;
+    instance->output = (outputSink){malloc(size), 0, size, size, instance->options.flushPolicy};
+    instance->cycles = 0;
+    instance->result = TAS_OK;
+    instance->message[0] = '\0';
+    return instance;
+}
+
+void tasFreeInstance(tasInstance * instance){
+    flushOutput(instance);
+    free(instance->output.text);
+    free(instance->reader.buffer);
+    freeFrameStack(&instance->stack);
+    if (instance->leafFrame != NULL){
+        freeTAS(instance->leafFrame);
+    }
+    if (instance->pureCalls != NULL){
+        tasFreeMemoCache(instance->pureCalls);
+    }
+    free(instance);
+}
+
+void tasSetInput(tasInstance * instance, tasReadFunction read, void * context){
+    instance->read = read;
+    instance->readContext = context;
+}
+
+void tasSetInputFile(tasInstance * instance, int file){
+    instance->reader.file = file;
+    instance->reader.length = 0;
+    instance->reader.position = 0;
+    instance->reader.values = NULL;
+    tasSetInput(instance, readFile, &instance->reader);
+}
+
+void tasSetInputValues(tasInstance * instance, const int * values, size_t count){
+    instance->reader.values = values;
+    instance->reader.valueCount = count;
+    instance->reader.valuesUsed = 0;
+    tasSetInput(instance, readArray, &instance->reader);
+}
+
+void tasSetOutput(tasInstance * instance, tasWriteFunction write, void * context){
+    flushOutput(instance);
+    instance->write = write;
+    instance->writeContext = context;
+}
+
+void tasSetOutputFile(tasInstance * instance, int file){
+    tasSetOutput(instance, writeFile, (void *)(intptr_t)file);
+}
+
+const char * tasGetOutput(tasInstance * instance, size_t * length){
+    *length = instance->output.length;
+    return instance->output.text;
+}
+
+void tasClearOutput(tasInstance * instance){
+    instance->output.length = 0;
+}
+
+int tasStart(tasInstance * instance, const int * arguments, unsigned int argumentCount, unsigned int returnCount){
+    frameStack * stack = &instance->stack;
+    instance->result = TAS_OK;
+    instance->message[0] = '\0';
+    instance->lastInput = 0;
+    instance->inputsRead = 0;
+    instance->cycles = 0;
+    stack->depth = 0;
+    stack->memoryUsed = 0;
+    stack->overBudget = false;
+
+    // Creating the initial TAS
+    TAS * tas = pushFrame(instance, instance->program->main, NULL, argumentCount, returnCount);
+    if (tas == NULL){
+        return instance->result;
+    }
+    if (argumentCount > 0){
+        memcpy(tas->arguments, arguments, sizeof(int) * argumentCount);
+    }
+    instance->result = TAS_RUNNING;
+    return TAS_RUNNING;
+}
+
+// Whether the first frame's activation queue is empty, runCycles has always returned from every other frame by then
+static bool isRunFinished(tasInstance * instance){
+    return instance->stack.depth == 1 && instance->stack.frames[0]->Activation->live == 0;
+}
+
+int tasResume(tasInstance * instance, unsigned long long quantum){
+    if (instance->result != TAS_RUNNING && instance->result != TAS_WAITING){
+        return instance->result;
+    }
+    instance->result = TAS_OK;
+
+    // Stopping at the cycle budget if it comes before the end of the quantum
+    unsigned long long limit = quantum;
+    bool atBudget = instance->options.cycleBudget > 0 && instance->options.cycleBudget - instance->cycles <= quantum;
+    if (atBudget){
+        limit = instance->options.cycleBudget - instance->cycles;
+    }
+
+    unsigned long long ran = 0;
+    if (instance->options.showStack){
+        // Running one cycle at a time so the stack can be shown after each one
+        // Only the first TAS is shown, so function calls are run until they return
+        TAS * tas = instance->stack.frames[0];
+        while (ran < limit && !isRunFinished(instance) && instance->result == TAS_OK){
+            ran += runCycles(instance, 1);
+            if (instance->stack.depth == 1){
+                flushOutput(instance);
+                showStack(tas);
+                puts("");
+            }
+        }
+    } else {
+        ran = runCycles(instance, limit);
+    }
+    instance->cycles += ran;
+
+    if (instance->result == TAS_OK && !isRunFinished(instance)){
+        if (atBudget){
+            char message [128];
+            sprintf(message, "Error: The program went over its budget of %llu cycles", instance->options.cycleBudget);
+            failRun(instance, TAS_ERROR_CYCLES, message);
+        } else {
+            // Output is only held on to between quanta, the run hasn't stopped yet
+            instance->result = TAS_RUNNING;
+            return TAS_RUNNING;
+        }
+    }
+    // The run has finished, failed or is waiting for input, so everything it wrote is handed on whatever the policy
+    flushOutput(instance);
+    return instance->result;
+}
+
+// Runs the first frame until its activation queue is empty, including the cycles of any functions it calls
+int tasRun(tasInstance * instance, const int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount,
+           unsigned long long * cycles){
+    int result = tasStart(instance, arguments, argumentCount, returnCount);
+    while (result == TAS_RUNNING){
+        result = tasResume(instance, ULLONG_MAX);
+    }
+
+    tasGetReturns(instance, returns, returnCount);
+    if (cycles != NULL){
+        *cycles = instance->cycles;
+    }
+    return result;
+}
+
+void tasGetReturns(tasInstance * instance, int * returns, unsigned int returnCount){
+    unsigned int given = 0;
+    if (instance->stack.depth > 0){
+        TAS * tas = instance->stack.frames[0];
+        given = tas->returnCount < returnCount ? tas->returnCount : returnCount;
+        if (given > 0){
+            memcpy(returns, tas->returns, sizeof(int) * given);
+        }
+    }
+    if (returnCount > given){
+        memset(returns + given, 0, sizeof(int) * (returnCount - given));
+    }
+}
+
+unsigned long long tasCycles(tasInstance * instance){
+    return instance->cycles;
+}
+
+const char * tasErrorMessage(tasInstance * instance){
+    return instance->message;
+}
+
+void tasShowVariableStats(tasInstance * instance){
+    if (instance->stack.pooled > 0){
+        tasShowVarStats(instance->stack.frames[0]->vm);
+    }
+}
+
+void tasShowCallStats(tasInstance * instance){
+    if (instance->pureCalls != NULL){
+        tasShowMemoStats(instance->pureCalls);
+    }
+}
@@ -0,0 +1,131 @@
+
+#ifndef TAS_TAS_H
+#define TAS_TAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Runs TAS programs from inside another program
+// A program is loaded once, along with every module it calls, and never changes after that, so any number of
+// instances can run it, one after another or at the same time on different threads
+// An instance holds everything a run needs and can run its program any number of times, but only on one thread at a time
+
+// What loading or running a program gives back
+#define TAS_OK 0
+#define TAS_ERROR_FILE 1 // The program could not be read
+#define TAS_ERROR_LINK 2 // The program, or a module it calls, has a remote activator with no tile to activate
+#define TAS_ERROR_MISSING_CALL 3 // A function call was made to a file that doesn't exist
+#define TAS_ERROR_MEMORY 4 // The run went over its memory budget
+#define TAS_ERROR_CYCLES 5 // The run went over its cycle budget
+// A run that gives one of these isn't finished and carries on from where it was with tasResume
+#define TAS_RUNNING 6 // The quantum it was given ran out
+#define TAS_WAITING 7 // A " tile is waiting for input, the read function said to wait
+#define TAS_ERROR_INPUT 8 // A " tile was given input that isn't an integer
+
+typedef struct TasProgramStruct tasProgram;
+typedef struct TasInstanceStruct tasInstance;
+
+// What a read function gives back
+#define TAS_INPUT_READ 0 // value has been set
+#define TAS_INPUT_END 1 // There is no more input, the " tile uses the last value that was read, or 0 if there wasn't one
+#define TAS_INPUT_WAIT 2 // There is no input yet, the run stops with TAS_WAITING and the " tile asks again when it is resumed
+#define TAS_INPUT_ERROR 3 // The input isn't an integer, the run stops with TAS_ERROR_INPUT
+
+// Gives the next value for a " tile
+typedef int (*tasReadFunction)(void * context, int * value);
+
+// Takes length characters of output from @ $ ; and the messages a program prints
+typedef void (*tasWriteFunction)(void * context, const char * text, size_t length);
+
+// When buffered output is handed to the write function, it always is when a run finishes, fails or waits for input
+#define TAS_FLUSH_NEWLINE 0 // At the end of each line, and before " asks for input so prompts are seen
+#define TAS_FLUSH_FULL 1 // Whenever the buffer is full
+#define TAS_FLUSH_EXIT 2 // Only when the run stops, the buffer grows to hold everything until then
+
+typedef struct TasOptionsStruct {
+    size_t memoryBudget; // How much memory the frames of a run may take up, including their variables, in bytes
+    unsigned long long cycleBudget; // How many cycles a run may take, 0 for no limit
+    bool useIntrinsics; // Whether stdlib functions with a native version use it
+    bool accelerateLoops; // Whether loops found when compiling are run natively
+    bool traceLoops; // Whether each loop that is run natively is reported in the output
+    bool memoise; // Whether calls to pure modules with the same arguments as an earlier call are answered from a cache
+    bool runLeaves; // Whether calls to small pure modules that make no calls of their own are run without pushing a frame
+    bool showStack; // Whether the first frame is shown on stdout after every cycle, for debugging
+    int flushPolicy; // One of the TAS_FLUSH_ policies
+    size_t outputBufferSize; // How much output is held before the buffer counts as full, in bytes
+} tasOptions;
+
+// Sets the options the TAS command line uses when no flags are given
+void tasDefaultOptions(tasOptions * options);
+
+// Loads a .ptas file, its binary image, or a .tas file that is preprocessed in memory, and every module it calls
+// Returns NULL when it can't be loaded, with result set to why
+tasProgram * tasLoadProgram(const char * path, int * result);
+
+// Loads .tas source that is already in memory, name is what the program is called in messages
+tasProgram * tasLoadSource(const char * name, const char * source, size_t length, int * result);
+
+void tasFreeProgram(tasProgram * program);
+
+// Creates an instance that runs program, reading from stdin and writing to stdout until told otherwise
+// Input is read as whitespace separated integers, anything else stops the run with TAS_ERROR_INPUT
+// options can be NULL for the defaults
+tasInstance * tasCreateInstance(tasProgram * program, const tasOptions * options);
+
+void tasFreeInstance(tasInstance * instance);
+
+void tasSetInput(tasInstance * instance, tasReadFunction read, void * context);
+
+// Reads input from a file descriptor, such as 0 for stdin, the same way stdin is read by default
+// The file is read in large blocks, so nothing else should read from it while the instance is using it
+void tasSetInputFile(tasInstance * instance, int file);
+
+// Gives " tiles count values in order, then the end of the input, the values aren't copied
+void tasSetInputValues(tasInstance * instance, const int * values, size_t count);
+
+// write can be NULL to keep the output in memory, see tasGetOutput
+// Anything still buffered is handed to the old write function first
+void tasSetOutput(tasInstance * instance, tasWriteFunction write, void * context);
+
+// Writes output to a file descriptor, such as 1 for stdout without going through stdio
+void tasSetOutputFile(tasInstance * instance, int file);
+
+// The output kept in memory since it was last cleared, when the write function is NULL
+// Otherwise whatever hasn't been flushed yet, the text isn't NUL terminated
+const char * tasGetOutput(tasInstance * instance, size_t * length);
+
+// Drops the output kept in memory, so the next tasGetOutput only has what was written after this
+void tasClearOutput(tasInstance * instance);
+
+// Runs the program until its activation queue is empty
+// arguments are used by ' tiles in order, and the values given to ^ tiles are written to returns, any not given are 0
+// cycles is set to how many cycles were run, including those of function calls, and can be NULL
+// Returns TAS_OK, TAS_WAITING, or the error that stopped the run, see tasErrorMessage
+int tasRun(tasInstance * instance, const int * arguments, unsigned int argumentCount, int * returns, unsigned int returnCount,
+           unsigned long long * cycles);
+
+// Starts a run that is carried out a piece at a time by tasResume, returnCount is how many values ^ tiles can give
+// Returns TAS_RUNNING, or TAS_ERROR_MEMORY if the first frame doesn't fit in the memory budget
+int tasStart(tasInstance * instance, const int * arguments, unsigned int argumentCount, unsigned int returnCount);
+
+// Carries on a started run for at most quantum cycles
+// Returns TAS_OK once it has finished, TAS_RUNNING or TAS_WAITING if it can be resumed, or the error that stopped it
+// Memory is checked when functions are called and at the end of each quantum
+int tasResume(tasInstance * instance, unsigned long long quantum);
+
+// Copies the values given to ^ tiles by the last run, any not given are 0
+void tasGetReturns(tasInstance * instance, int * returns, unsigned int returnCount);
+
+// How many cycles the last run has taken so far
+unsigned long long tasCycles(tasInstance * instance);
+
+// Describes the error the last run stopped with, an empty string if it didn't
+const char * tasErrorMessage(tasInstance * instance);
+
+// Shows how the joiner variables of the first frame of the last run were stored, on stdout
+void tasShowVariableStats(tasInstance * instance);
+
+// Shows how well calls to pure modules were cached, on stdout, nothing if they weren't
+void tasShowCallStats(tasInstance * instance);
+
+#endif //TAS_TAS_H
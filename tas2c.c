@@ -0,0 +1,1244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "module.h"
+#include "varmgr.h"
+
+// Translates a program and every module it calls into one C file that runs it without the interpreter
+// Every module's tiles become labels in one function, with each module's variables in an array indexed by slot
+// & calls push a frame on an explicit stack and jump to the called module, like the interpreter's frame stack, so deep
+// recursion is limited by the memory budget rather than the C stack, and a call returns by jumping back to a label
+// just after it
+//
+// The activation queue is kept so tiles run in exactly the order the interpreter runs them, but when a span is activated
+// while nothing else is queued its tiles are run straight through in order without being linked into the queue
+// Activating a span or a tile while nothing is queued jumps straight to it, so most control flow becomes plain jumps
+
+// The same default as the interpreter's
+#define DEFAULT_MEMORY_BUDGET ((size_t)256 * 1024 * 1024)
+
+// The runtime every generated file starts with
+const char * runtimeSource =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <limits.h>\n"
+    "\n"
+    "// Joiner names with one joiner and an index from 0 up to this are stored in dense arrays, others go in a table by name\n"
+    "#define TAS_MAX_DENSE_INDEX (1 << 22)\n"
+    "\n"
+    "// The values of every name:index variable with the same name, anything at or past length is 0\n"
+    "typedef struct {\n"
+    "    int * values;\n"
+    "    unsigned int length;\n"
+    "    unsigned int capacity;\n"
+    "} tasArray;\n"
+    "\n"
+    "// The values of joiner names that can't go in a dense array, a name that isn't there reads as 0\n"
+    "typedef struct {\n"
+    "    char ** names;\n"
+    "    int * values;\n"
+    "    unsigned int size; // Always a power of 2, or 0 before anything is added\n"
+    "    unsigned int count;\n"
+    "} tasTable;\n"
+    "\n"
+    "// The tiles waiting to run, as a list linked through the tiles so deactivating one doesn't have to search\n"
+    "typedef struct {\n"
+    "    int * next;\n"
+    "    int * previous;\n"
+    "    unsigned char * queued;\n"
+    "    int head;\n"
+    "    int tail;\n"
+    "    unsigned int live;\n"
+    "} tasQueue;\n"
+    "\n"
+    "struct tasPoolStruct;\n"
+    "\n"
+    "// A running call of a module\n"
+    "typedef struct {\n"
+    "    int * slots;\n"
+    "    tasArray * arrays;\n"
+    "    tasTable table;\n"
+    "    tasQueue queue;\n"
+    "    int * arguments;\n"
+    "    unsigned int argumentCount;\n"
+    "    unsigned int argumentsUsed;\n"
+    "    unsigned int argumentCapacity;\n"
+    "    int * returns; // Given to the caller's return holders once the call ends, any not set by ^ are 0\n"
+    "    unsigned int returnCount;\n"
+    "    unsigned int returnsUsed;\n"
+    "    unsigned int returnCapacity;\n"
+    "    unsigned int resume; // Where the caller carries on from once the call ends\n"
+    "    size_t memory; // How much memory the frame takes up, counted against the memory budget\n"
+    "    struct tasPoolStruct * pool;\n"
+    "} tasFrame;\n"
+    "\n"
+    "// The frames of one module, frames past depth are kept for later calls to reuse\n"
+    "typedef struct tasPoolStruct {\n"
+    "    unsigned int tileCount;\n"
+    "    unsigned int slotCount;\n"
+    "    unsigned int arrayCount;\n"
+    "    tasFrame ** frames;\n"
+    "    unsigned int depth;\n"
+    "    unsigned int pooled;\n"
+    "    unsigned int capacity;\n"
+    "} tasPool;\n"
+    "\n"
+    "// Every call that is running, the running one is at tasDepth - 1\n"
+    "static tasFrame ** tasStack = NULL;\n"
+    "static unsigned int tasDepth = 0;\n"
+    "static unsigned int tasStackCapacity = 0;\n"
+    "static size_t tasMemoryUsed = 0;\n"
+    "\n"
+    "// A variable with a joiner, resolved when it is used\n"
+    "typedef struct {\n"
+    "    const char * name; // The name before the first joiner\n"
+    "    unsigned int baseLength;\n"
+    "    unsigned int joinCount;\n"
+    "    const int * joinSlots; // The slot of the name after each joiner, -1 for an empty name\n"
+    "    int array; // The dense array for names with one joiner, -1 otherwise\n"
+    "} tasPoint;\n"
+    "\n"
+    "// The last number read by \", kept once the input has ended\n"
+    "static int tasInputValue = 0;\n"
+    "static unsigned long long tasInputsRead = 0; // For pointing out input that isn't a number\n"
+    "\n"
+    "static inline unsigned int tasHash(const char * name){\n"
+    "    unsigned int hash = 2166136261u;\n"
+    "    for (const char * c = name; *c != '\\0'; c++){\n"
+    "        hash ^= (unsigned char)*c;\n"
+    "        hash *= 16777619u;\n"
+    "    }\n"
+    "    return hash;\n"
+    "}\n"
+    "\n"
+    "// Stops the program the way the interpreter does when it goes over its memory budget\n"
+    "static void tasOutOfMemory(const char * message){\n"
+    "    printf(\"Error: %s\\n\", message);\n"
+    "    exit(1);\n"
+    "}\n"
+    "\n"
+    "// Counts memory a frame has taken up while running, stopping the program as soon as it goes over the budget\n"
+    "static inline void tasGrow(tasFrame * frame, size_t grown){\n"
+    "    frame->memory += grown;\n"
+    "    tasMemoryUsed += grown;\n"
+    "    if (tasMemoryUsed > TAS_MEMORY_BUDGET){\n"
+    "        char message [96];\n"
+    "        sprintf(message, \"The program went over its memory budget of %zu bytes\", (size_t)TAS_MEMORY_BUDGET);\n"
+    "        tasOutOfMemory(message);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// Returns where the value of a name is kept in a frame's table, or NULL if it isn't there and adding is false\n"
+    "static inline int * tasTableFind(tasFrame * frame, const char * name, bool adding){\n"
+    "    tasTable * table = &frame->table;\n"
+    "    if (table->size == 0){\n"
+    "        if (!adding){\n"
+    "            return NULL;\n"
+    "        }\n"
+    "        table->size = 16;\n"
+    "        table->names = calloc(table->size, sizeof(char *));\n"
+    "        table->values = calloc(table->size, sizeof(int));\n"
+    "        tasGrow(frame, (sizeof(char *) + sizeof(int)) * table->size);\n"
+    "    }\n"
+    "    if (adding && (table->count + 1) * 10 > table->size * 7){\n"
+    "        // Keeping the table at most 70% full\n"
+    "        tasGrow(frame, (sizeof(char *) + sizeof(int)) * table->size);\n"
+    "        unsigned int oldSize = table->size;\n"
+    "        char ** oldNames = table->names;\n"
+    "        int * oldValues = table->values;\n"
+    "        table->size *= 2;\n"
+    "        table->names = calloc(table->size, sizeof(char *));\n"
+    "        table->values = calloc(table->size, sizeof(int));\n"
+    "        for (unsigned int i = 0; i < oldSize; i++){\n"
+    "            if (oldNames[i] != NULL){\n"
+    "                unsigned int index = tasHash(oldNames[i]) & (table->size - 1);\n"
+    "                while (table->names[index] != NULL){\n"
+    "                    index = (index + 1) & (table->size - 1);\n"
+    "                }\n"
+    "                table->names[index] = oldNames[i];\n"
+    "                table->values[index] = oldValues[i];\n"
+    "            }\n"
+    "        }\n"
+    "        free(oldNames);\n"
+    "        free(oldValues);\n"
+    "    }\n"
+    "\n"
+    "    unsigned int index = tasHash(name) & (table->size - 1);\n"
+    "    while (table->names[index] != NULL){\n"
+    "        if (strcmp(table->names[index], name) == 0){\n"
+    "            return &table->values[index];\n"
+    "        }\n"
+    "        index = (index + 1) & (table->size - 1);\n"
+    "    }\n"
+    "    if (!adding){\n"
+    "        return NULL;\n"
+    "    }\n"
+    "    tasGrow(frame, strlen(name) + 1);\n"
+    "    table->names[index] = malloc(strlen(name) + 1);\n"
+    "    strcpy(table->names[index], name);\n"
+    "    table->values[index] = 0;\n"
+    "    table->count++;\n"
+    "    return &table->values[index];\n"
+    "}\n"
+    "\n"
+    "static inline void tasClearTable(tasTable * table){\n"
+    "    if (table->count == 0){\n"
+    "        return;\n"
+    "    }\n"
+    "    for (unsigned int i = 0; i < table->size; i++){\n"
+    "        free(table->names[i]);\n"
+    "        table->names[i] = NULL;\n"
+    "    }\n"
+    "    table->count = 0;\n"
+    "}\n"
+    "\n"
+    "// Makes sure a frame's arguments or returns have room for count values\n"
+    "static inline int * tasReserve(int * values, unsigned int * capacity, unsigned int count){\n"
+    "    if (count > *capacity){\n"
+    "        free(values);\n"
+    "        *capacity = count;\n"
+    "        values = malloc(sizeof(int) * count);\n"
+    "    }\n"
+    "    return values;\n"
+    "}\n"
+    "\n"
+    "// Pushes a frame for a call of a module, reusing one from an earlier call when there is one\n"
+    "// Stops the program if the frames in use would go over the memory budget, as the interpreter does\n"
+    "static inline tasFrame * tasPushFrame(tasPool * pool, unsigned int argumentCount, unsigned int returnCount){\n"
+    "    if (pool->depth == pool->pooled){\n"
+    "        if (pool->pooled == pool->capacity){\n"
+    "            pool->capacity = pool->capacity == 0 ? 16 : pool->capacity * 2;\n"
+    "            pool->frames = realloc(pool->frames, sizeof(tasFrame *) * pool->capacity);\n"
+    "        }\n"
+    "        unsigned int tileCount = pool->tileCount > 0 ? pool->tileCount : 1;\n"
+    "        tasFrame * frame = calloc(1, sizeof(tasFrame));\n"
+    "        frame->slots = malloc(sizeof(int) * (pool->slotCount > 0 ? pool->slotCount : 1));\n"
+    "        frame->arrays = calloc(pool->arrayCount > 0 ? pool->arrayCount : 1, sizeof(tasArray));\n"
+    "        frame->queue.next = malloc(sizeof(int) * tileCount);\n"
+    "        frame->queue.previous = malloc(sizeof(int) * tileCount);\n"
+    "        frame->queue.queued = calloc(tileCount, 1);\n"
+    "        frame->pool = pool;\n"
+    "        pool->frames[pool->pooled] = frame;\n"
+    "        pool->pooled++;\n"
+    "    }\n"
+    "\n"
+    "    // A frame is only given back once its queue is empty, so only its variables need resetting\n"
+    "    tasFrame * frame = pool->frames[pool->depth];\n"
+    "    memset(frame->slots, 0, sizeof(int) * pool->slotCount);\n"
+    "    size_t arrayMemory = 0;\n"
+    "    for (unsigned int i = 0; i < pool->arrayCount; i++){\n"
+    "        frame->arrays[i].length = 0;\n"
+    "        arrayMemory += sizeof(int) * frame->arrays[i].capacity;\n"
+    "    }\n"
+    "    tasClearTable(&frame->table);\n"
+    "    frame->queue.head = -1;\n"
+    "    frame->queue.tail = -1;\n"
+    "    frame->queue.live = 0;\n"
+    "    frame->arguments = tasReserve(frame->arguments, &frame->argumentCapacity, argumentCount);\n"
+    "    frame->returns = tasReserve(frame->returns, &frame->returnCapacity, returnCount);\n"
+    "    frame->argumentCount = argumentCount;\n"
+    "    frame->argumentsUsed = 0;\n"
+    "    frame->returnCount = returnCount;\n"
+    "    frame->returnsUsed = 0;\n"
+    "    if (returnCount > 0){\n"
+    "        memset(frame->returns, 0, sizeof(int) * returnCount);\n"
+    "    }\n"
+    "\n"
+    "    frame->memory = sizeof(tasFrame) + sizeof(int) * (pool->slotCount + frame->argumentCapacity + frame->returnCapacity)\n"
+    "            + (sizeof(int) * 2 + 1) * pool->tileCount + sizeof(tasArray) * pool->arrayCount + arrayMemory\n"
+    "            + (sizeof(char *) + sizeof(int)) * frame->table.size;\n"
+    "    if (tasMemoryUsed + frame->memory > TAS_MEMORY_BUDGET){\n"
+    "        char message [128];\n"
+    "        sprintf(message, \"Function calls ran out of memory after %u calls deep, the limit is %zu bytes\", tasDepth,\n"
+    "                (size_t)TAS_MEMORY_BUDGET);\n"
+    "        tasOutOfMemory(message);\n"
+    "    }\n"
+    "    tasMemoryUsed += frame->memory;\n"
+    "    pool->depth++;\n"
+    "    if (tasDepth == tasStackCapacity){\n"
+    "        tasStackCapacity = tasStackCapacity == 0 ? 64 : tasStackCapacity * 2;\n"
+    "        tasStack = realloc(tasStack, sizeof(tasFrame *) * tasStackCapacity);\n"
+    "    }\n"
+    "    tasStack[tasDepth] = frame;\n"
+    "    tasDepth++;\n"
+    "    return frame;\n"
+    "}\n"
+    "\n"
+    "// Pops the running frame once its queue is empty\n"
+    "static inline void tasPopFrame(void){\n"
+    "    tasDepth--;\n"
+    "    tasFrame * frame = tasStack[tasDepth];\n"
+    "    frame->pool->depth--;\n"
+    "    tasMemoryUsed -= frame->memory;\n"
+    "}\n"
+    "\n"
+    "// The frame of the call that just ended, its returns stay as they are until something else is pushed\n"
+    "static inline tasFrame * tasReturned(void){\n"
+    "    return tasStack[tasDepth];\n"
+    "}\n"
+    "\n"
+    "// Adds a tile to the end of the queue if it isn't already queued\n"
+    "static inline void tasActivate(tasQueue * queue, int index){\n"
+    "    if (queue->queued[index]){\n"
+    "        return;\n"
+    "    }\n"
+    "    queue->queued[index] = 1;\n"
+    "    queue->next[index] = -1;\n"
+    "    queue->previous[index] = queue->tail;\n"
+    "    if (queue->tail == -1){\n"
+    "        queue->head = index;\n"
+    "    } else {\n"
+    "        queue->next[queue->tail] = index;\n"
+    "    }\n"
+    "    queue->tail = index;\n"
+    "    queue->live++;\n"
+    "}\n"
+    "\n"
+    "// Adds the tiles from start up to but not including end, moving in direction\n"
+    "static inline void tasActivateRange(tasQueue * queue, int start, int end, int direction){\n"
+    "    for (int i = start; i != end; i += direction){\n"
+    "        tasActivate(queue, i);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// Removes the tiles from start up to but not including end, moving in direction\n"
+    "static inline void tasDeactivateRange(tasQueue * queue, int start, int end, int direction){\n"
+    "    for (int i = start; i != end; i += direction){\n"
+    "        if (!queue->queued[i]){\n"
+    "            continue;\n"
+    "        }\n"
+    "        queue->queued[i] = 0;\n"
+    "        int next = queue->next[i];\n"
+    "        int previous = queue->previous[i];\n"
+    "        if (previous == -1){\n"
+    "            queue->head = next;\n"
+    "        } else {\n"
+    "            queue->next[previous] = next;\n"
+    "        }\n"
+    "        if (next == -1){\n"
+    "            queue->tail = previous;\n"
+    "        } else {\n"
+    "            queue->previous[next] = previous;\n"
+    "        }\n"
+    "        queue->live--;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// Takes the first tile off the queue, there must be one linked\n"
+    "static inline int tasNextActivation(tasQueue * queue){\n"
+    "    int index = queue->head;\n"
+    "    queue->head = queue->next[index];\n"
+    "    if (queue->head == -1){\n"
+    "        queue->tail = -1;\n"
+    "    } else {\n"
+    "        queue->previous[queue->head] = -1;\n"
+    "    }\n"
+    "    queue->queued[index] = 0;\n"
+    "    queue->live--;\n"
+    "    return index;\n"
+    "}\n"
+    "\n"
+    "// Returns the index of a point with a dense array, or -1 if the index is outside of what arrays are kept for\n"
+    "static inline int tasDenseIndex(const int * slots, const tasPoint * point){\n"
+    "    int index = point->joinSlots[0] == -1 ? 0 : slots[point->joinSlots[0]];\n"
+    "    return (index >= 0 && index < TAS_MAX_DENSE_INDEX) ? index : -1;\n"
+    "}\n"
+    "\n"
+    "// Returns where an element of one of a frame's dense arrays is kept, growing the array to fit it\n"
+    "static inline int * tasDenseElement(tasFrame * frame, tasArray * array, int index){\n"
+    "    if ((unsigned int)index >= array->length){\n"
+    "        if ((unsigned int)index >= array->capacity){\n"
+    "            unsigned int capacity = array->capacity == 0 ? 16 : array->capacity;\n"
+    "            while (capacity <= (unsigned int)index){\n"
+    "                capacity *= 2;\n"
+    "            }\n"
+    "            tasGrow(frame, sizeof(int) * (capacity - array->capacity));\n"
+    "            array->values = realloc(array->values, sizeof(int) * capacity);\n"
+    "            array->capacity = capacity;\n"
+    "        }\n"
+    "        memset(array->values + array->length, 0, sizeof(int) * (index + 1 - array->length));\n"
+    "        array->length = index + 1;\n"
+    "    }\n"
+    "    return &array->values[index];\n"
+    "}\n"
+    "\n"
+    "// Builds the full name of a joiner point i.e. arr:i becomes arr:17 when i is 17\n"
+    "static inline void tasJoinName(const int * slots, const tasPoint * point, char * buffer){\n"
+    "    memcpy(buffer, point->name, point->baseLength);\n"
+    "    unsigned int length = point->baseLength;\n"
+    "    for (unsigned int i = 0; i < point->joinCount; i++){\n"
+    "        int value = point->joinSlots[i] == -1 ? 0 : slots[point->joinSlots[i]];\n"
+    "        length += sprintf(buffer + length, \":%d\", value);\n"
+    "    }\n"
+    "    buffer[length] = '\\0';\n"
+    "}\n"
+    "\n"
+    "// Returns where the value of a joiner point without a dense array element is kept by its full name\n"
+    "// NULL if it has never been set and adding is false\n"
+    "static inline int * tasFindNamed(tasFrame * frame, const tasPoint * point, bool adding){\n"
+    "    char name [point->baseLength + point->joinCount * 12 + 1];\n"
+    "    tasJoinName(frame->slots, point, name);\n"
+    "    return tasTableFind(frame, name, adding);\n"
+    "}\n"
+    "\n"
+    "// Returns where the value of a joiner point is kept, or NULL if it has never been set and adding is false\n"
+    "static inline int * tasFindPoint(tasFrame * frame, const tasPoint * point, bool adding){\n"
+    "    if (point->array != -1){\n"
+    "        int index = tasDenseIndex(frame->slots, point);\n"
+    "        if (index != -1){\n"
+    "            tasArray * array = &frame->arrays[point->array];\n"
+    "            if ((unsigned int)index < array->length){\n"
+    "                return &array->values[index];\n"
+    "            }\n"
+    "            return adding ? tasDenseElement(frame, array, index) : NULL;\n"
+    "        }\n"
+    "    }\n"
+    "    return tasFindNamed(frame, point, adding);\n"
+    "}\n"
+    "\n"
+    "static inline int tasGet(tasFrame * frame, const tasPoint * point){\n"
+    "    int * value = tasFindPoint(frame, point, false);\n"
+    "    return value != NULL ? *value : 0;\n"
+    "}\n"
+    "\n"
+    "static inline void tasSet(tasFrame * frame, const tasPoint * point, int value){\n"
+    "    *tasFindPoint(frame, point, true) = value;\n"
+    "}\n"
+    "\n"
+    "static inline void tasChange(tasFrame * frame, const tasPoint * point, int change){\n"
+    "    int * value = tasFindPoint(frame, point, true);\n"
+    "    *value = (int)((unsigned int)*value + (unsigned int)change);\n"
+    "}\n"
+    "\n"
+    "static inline void tasRemove(tasFrame * frame, const tasPoint * point){\n"
+    "    int * value = tasFindPoint(frame, point, false);\n"
+    "    if (value != NULL){\n"
+    "        *value = 0;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// Reads a number for \", the end of the input leaves the last number read and anything else stops the program\n"
+    "// the same as the interpreter\n"
+    "static inline int tasReadInput(void){\n"
+    "    int got = scanf(\"%d\", &tasInputValue);\n"
+    "    if (got == 1){\n"
+    "        tasInputsRead++;\n"
+    "    } else if (got == 0){\n"
+    "        printf(\"Error: Input %llu is not an integer from %d to %d\\n\", tasInputsRead + 1, INT_MIN, INT_MAX);\n"
+    "        exit(1);\n"
+    "    }\n"
+    "    return tasInputValue;\n"
+    "}\n"
+    "\n"
+    "static inline void tasNoParameter(void){\n"
+    "    puts(\"Variable is being set to 0 because there are no more parameters\");\n"
+    "}\n"
+    "\n"
+    "static inline void tasMissingFile(const char * fileName){\n"
+    "    printf(\"File %s does not exist\\n\", fileName);\n"
+    "    exit(1);\n"
+    "}\n"
+    "\n"
+    "// Applies a counted loop's affine map to its variables the given number of times, squaring the map to need only log(iterations) steps\n"
+    "static inline void tasApplyLoop(int * slots, const unsigned int * loopSlots, unsigned int slotCount, const unsigned int * transform, unsigned long long iterations){\n"
+    "    unsigned int width = slotCount + 1;\n"
+    "    unsigned int values [width];\n"
+    "    unsigned int next [width];\n"
+    "    unsigned int power [width * width];\n"
+    "    unsigned int squared [width * width];\n"
+    "    for (unsigned int r = 0; r < slotCount; r++){\n"
+    "        values[r] = (unsigned int)slots[loopSlots[r]];\n"
+    "    }\n"
+    "    values[slotCount] = 1;\n"
+    "    memcpy(power, transform, sizeof(power));\n"
+    "\n"
+    "    while (iterations > 0){\n"
+    "        if (iterations & 1){\n"
+    "            for (unsigned int r = 0; r < width; r++){\n"
+    "                unsigned int sum = 0;\n"
+    "                for (unsigned int c = 0; c < width; c++){\n"
+    "                    sum += power[r * width + c] * values[c];\n"
+    "                }\n"
+    "                next[r] = sum;\n"
+    "            }\n"
+    "            memcpy(values, next, sizeof(values));\n"
+    "        }\n"
+    "        iterations >>= 1;\n"
+    "        if (iterations > 0){\n"
+    "            for (unsigned int r = 0; r < width; r++){\n"
+    "                for (unsigned int c = 0; c < width; c++){\n"
+    "                    unsigned int sum = 0;\n"
+    "                    for (unsigned int k = 0; k < width; k++){\n"
+    "                        sum += power[r * width + k] * power[k * width + c];\n"
+    "                    }\n"
+    "                    squared[r * width + c] = sum;\n"
+    "                }\n"
+    "            }\n"
+    "            memcpy(power, squared, sizeof(power));\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    for (unsigned int r = 0; r < slotCount; r++){\n"
+    "        slots[loopSlots[r]] = (int)values[r];\n"
+    "    }\n"
+    "}\n";
+
+// Every module the program can reach, in the order they were found
+typedef struct ProgramStruct {
+    Module ** modules;
+    bool * loaded; // Whether each module was loaded here, rather than coming with another module's bundle
+    int ** targets; // The module each tile of each module calls, -1 for tiles that aren't calls or call a missing file
+    unsigned int count;
+    unsigned int capacity;
+    struct varmgr * paths; // Maps the path of each module loaded here to its index + 1
+    unsigned int resumeCount; // How many calls have been written, each one carries on from its own label
+} program;
+
+// What is needed while writing the code for one module
+typedef struct EmitterStruct {
+    FILE * out;
+    program * prog;
+    unsigned int index; // The module being written
+    Module * module;
+    unsigned int * pointIndex; // Where each joiner point is in the module's table of them
+    bool * rightStarts; // The tiles that start a span run straight through to the right
+    bool * leftStarts;
+    // The rest of the span being run straight through, from pendingLow up to but not including pendingHigh
+    // These tiles count as queued without being in the queue, there are none while running a tile taken off the queue
+    int pendingLow;
+    int pendingHigh;
+} emitter;
+
+// Returns whether there is a program to load at a path, either as text or as a binary image
+bool moduleExists(const char * path){
+    FILE * file = fopen(path, "r");
+    if (file == NULL){
+        char imageName [strlen(path) + 2];
+        strcpy(imageName, path);
+        strcat(imageName, "b");
+        file = fopen(imageName, "r");
+    }
+    if (file == NULL){
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+// Adds a module to the program and returns its index
+unsigned int addModule(program * prog, Module * module, bool loaded){
+    if (prog->count == prog->capacity){
+        prog->capacity = prog->capacity == 0 ? 8 : prog->capacity * 2;
+        prog->modules = realloc(prog->modules, sizeof(Module *) * prog->capacity);
+        prog->loaded = realloc(prog->loaded, sizeof(bool) * prog->capacity);
+        prog->targets = realloc(prog->targets, sizeof(int *) * prog->capacity);
+    }
+    prog->modules[prog->count] = module;
+    prog->loaded[prog->count] = loaded;
+    prog->targets[prog->count] = NULL;
+    prog->count++;
+    return prog->count - 1;
+}
+
+// Returns the index of the module at a path, loading it the first time
+unsigned int findModule(program * prog, char * path){
+    int index = tasGetVar(path, prog->paths) - 1;
+    if (index == -1){
+        Module * module = tasLoadModule(path);
+        if (module == NULL){
+            printf("Error: %s could not be loaded\n", path);
+            exit(1);
+        }
+        index = (int)addModule(prog, module, true);
+        tasSetVar(path, index + 1, prog->paths);
+    }
+    return (unsigned int)index;
+}
+
+// Works out the module a call runs the same way the interpreter does, returning -1 if the file doesn't exist
+// Calls linked when a bundle was loaded keep their module, others look in the current folder and then the stdlib folder
+int findCallTarget(program * prog, Call * call){
+    if (call->module != NULL){
+        for (unsigned int i = 0; i < prog->count; i++){
+            if (prog->modules[i] == call->module){
+                return (int)i;
+            }
+        }
+        return (int)addModule(prog, call->module, false);
+    }
+    if (moduleExists(call->fileName)){
+        return (int)findModule(prog, call->fileName);
+    }
+    char path [strlen(call->fileName) + 8];
+    strcpy(path, "stdlib/");
+    strcat(path, call->fileName);
+    if (moduleExists(path)){
+        return (int)findModule(prog, path);
+    }
+    return -1;
+}
+
+// Finds every module the program can reach and what each of their calls runs
+void findCallTargets(program * prog){
+    // Modules are added to the end as they are found, so this reaches everything
+    for (unsigned int i = 0; i < prog->count; i++){
+        Module * module = prog->modules[i];
+        int * targets = malloc(sizeof(int) * (module->length > 0 ? module->length : 1));
+        for (unsigned int j = 0; j < module->length; j++){
+            Call * call = module->code[j].call;
+            targets[j] = call != NULL ? findCallTarget(prog, call) : -1;
+        }
+        prog->targets[i] = targets;
+    }
+}
+
+// Returns the tile after index in a span run straight through in direction, or -1 if the span ends at index
+// Spans stop before a blocker or just after a poker
+int spanNext(Module * module, int index, int direction){
+    int next = index + direction;
+    char type = module->types[index];
+    if (type == '}' || type == '{' || next < 0 || next >= (int)module->length || module->types[next] == '_'){
+        return -1;
+    }
+    return next;
+}
+
+// Returns where a span run straight through from index ends, the end itself is not part of it
+int spanEnd(Module * module, int index, int direction){
+    int next;
+    while ((next = spanNext(module, index, direction)) != -1){
+        index = next;
+    }
+    return index + direction;
+}
+
+// Whether activating from start up to end is done by running the span straight through when nothing else is queued
+// Single tiles are jumped to instead
+bool isStraightSpan(int start, int end){
+    return abs(end - start) >= 2;
+}
+
+// Writes the C expression for the value of a variable into buffer
+void pointValue(emitter * e, Point * point, char * buffer){
+    if (point->slot != -1){
+        sprintf(buffer, "slots[%d]", point->slot);
+    } else {
+        sprintf(buffer, "tasGet(frame, &points%u[%u])", e->index, e->pointIndex[point - e->module->points]);
+    }
+}
+
+// Writes the C expression for the value of a ? or = operand into buffer
+void operandValue(emitter * e, Operand * operand, char * buffer){
+    if (operand->kind == OPERAND_SLOT){
+        sprintf(buffer, "slots[%d]", operand->value);
+    } else if (operand->kind == OPERAND_POINT){
+        pointValue(e, operand->point, buffer);
+    } else {
+        sprintf(buffer, "%d", operand->value);
+    }
+}
+
+void writeSet(emitter * e, Point * point, const char * value, const char * indent){
+    if (point->slot != -1){
+        fprintf(e->out, "%sslots[%d] = %s;\n", indent, point->slot, value);
+    } else {
+        fprintf(e->out, "%stasSet(frame, &points%u[%u], %s);\n", indent, e->index, e->pointIndex[point - e->module->points], value);
+    }
+}
+
+// Whether a tile is part of the rest of the span being run straight through, so activating it does nothing
+bool isPending(emitter * e, int index){
+    return index >= e->pendingLow && index < e->pendingHigh;
+}
+
+// Writes activating a single tile, which is jumped to when nothing else is queued
+void writeActivation(emitter * e, int index, const char * indent){
+    if (isPending(e, index)){
+        return;
+    }
+    if (e->pendingLow != e->pendingHigh){
+        fprintf(e->out, "%stasActivate(queue, %d);\n", indent, index);
+    } else if (e->module->code[index].op == OP_NOP){
+        // Running a tile that does nothing with nothing else queued would leave the queue empty again
+        fprintf(e->out, "%sif (queue->live != 0){ tasActivate(queue, %d); }\n", indent, index);
+    } else {
+        fprintf(e->out, "%sif (queue->live == 0){ goto tile%u_%d; }\n", indent, e->index, index);
+        fprintf(e->out, "%stasActivate(queue, %d);\n", indent, index);
+    }
+}
+
+// Writes adding the tiles from start up to but not including end to the queue, if there are any
+void writeRange(emitter * e, int start, int end, int direction, const char * indent){
+    if ((end - start) * direction <= 0){
+        return;
+    }
+    if (abs(end - start) == 1){
+        fprintf(e->out, "%stasActivate(queue, %d);\n", indent, start);
+    } else {
+        fprintf(e->out, "%stasActivateRange(queue, %d, %d, %d);\n", indent, start, end, direction);
+    }
+}
+
+// Writes activating a span from start up to but not including end
+// With nothing queued a span of more than one tile is run straight through
+void writeSpan(emitter * e, int start, int end, int direction, const char * indent){
+    if (start == end){
+        return;
+    }
+    if (!isStraightSpan(start, end)){
+        writeActivation(e, start, indent);
+        return;
+    }
+    if (e->pendingLow == e->pendingHigh){
+        fprintf(e->out, "%sif (queue->live == 0){ goto %s%u_%d; }\n", indent, direction == 1 ? "right" : "left", e->index, start);
+        fprintf(e->out, "%stasActivateRange(queue, %d, %d, %d);\n", indent, start, end, direction);
+        return;
+    }
+
+    // Something is always pending here, so only the tiles on either side of the pending ones are added, in order
+    int low = direction == 1 ? start : end + 1;
+    int high = direction == 1 ? end : start + 1;
+    int below = high < e->pendingLow ? high : e->pendingLow; // The tiles from low up to below come before the pending ones
+    int above = low > e->pendingHigh ? low : e->pendingHigh; // The tiles from above up to high come after them
+    if (direction == 1){
+        writeRange(e, low, below, 1, indent);
+        writeRange(e, above, high, 1, indent);
+    } else {
+        writeRange(e, high - 1, above - 1, -1, indent);
+        writeRange(e, below - 1, low - 1, -1, indent);
+    }
+}
+
+// Writes deactivating a span from the tile after index up to but not including end
+// When the tile doing it is part of a span being run straight through in the same direction, the rest of that span is
+// pending rather than queued, so it is dropped by stopping the span there
+// Returns whether the tile's code ends there
+bool writeDeactivation(emitter * e, int index, int end, int direction, char context){
+    int start = index + direction;
+    if (context == (direction == 1 ? 'R' : 'L')){
+        int rest = direction == 1 ? e->pendingHigh : e->pendingLow - 1;
+        if (rest != end){
+            fprintf(e->out, "    tasDeactivateRange(queue, %d, %d, %d);\n", rest, end, direction);
+        }
+        fprintf(e->out, "    goto next%u;\n", e->index);
+        return true;
+    }
+    if (start != end){
+        fprintf(e->out, "    tasDeactivateRange(queue, %d, %d, %d);\n", start, end, direction);
+    }
+    return false;
+}
+
+// Writes running a loop found when compiling, for when its ? is the only tile activated
+void writeLoop(emitter * e, unsigned int index, Instruction * compare){
+    Loop * loop = compare->loop;
+    char left [64];
+    char right [64];
+    operandValue(e, &compare->left, left);
+    operandValue(e, &compare->right, right);
+
+    fprintf(e->out, "    if (queue->live == 0){\n");
+    if (loop->counter != -1){
+        char fixed [64];
+        operandValue(e, loop->counterOnRight ? &compare->left : &compare->right, fixed);
+        long long stepSize = loop->step < 0 ? -(long long)loop->step : loop->step;
+        fprintf(e->out, "        long long counter = slots[%u];\n", loop->slots[loop->counter]);
+        if (loop->counterOnRight){
+            fprintf(e->out, "        long long distance = counter - (long long)%s;\n", fixed);
+        } else {
+            fprintf(e->out, "        long long distance = (long long)%s - counter;\n", fixed);
+        }
+        fprintf(e->out, "        long long iterations = distance <= 0 ? 0 : (distance + %lld) / %lld;\n", stepSize - 1, stepSize);
+        fprintf(e->out, "        long long last = counter + iterations * %d;\n", loop->step);
+        fprintf(e->out, "        if (last >= INT_MIN && last <= INT_MAX){\n");
+        fprintf(e->out, "            tasApplyLoop(slots, loopSlots%u_%u, %u, loopTransform%u_%u, (unsigned long long)iterations);\n",
+                e->index, index, loop->slotCount, e->index, index);
+        fprintf(e->out, "        } else {\n");
+    }
+
+    // Going round one iteration at a time, but without going through the queue
+    const char * indent = loop->counter != -1 ? "            " : "        ";
+    fprintf(e->out, "%swhile (%s > %s){\n", indent, right, left);
+    for (unsigned int i = 0; i < loop->stepCount; i++){
+        LoopStep * step = &loop->steps[i];
+        if (step->op == OP_ASSIGN){
+            char stepLeft [64];
+            char stepRight [64];
+            operandValue(e, &step->left, stepLeft);
+            operandValue(e, &step->right, stepRight);
+            fprintf(e->out, "%s    slots[%d] = (int)((unsigned int)%s + (unsigned int)%s);\n", indent, step->slot, stepLeft, stepRight);
+        } else {
+            fprintf(e->out, "%s    slots[%d] = (int)((unsigned int)slots[%d] %c 1u);\n", indent, step->slot, step->slot, step->op == OP_INCREMENT ? '+' : '-');
+        }
+    }
+    fprintf(e->out, "%s}\n", indent);
+    if (loop->counter != -1){
+        fprintf(e->out, "        }\n");
+    }
+    fprintf(e->out, "    }\n");
+}
+
+// Writes the code for one tile, context is D when it was taken off the queue and R or L when it is part of a span
+// being run straight through in that direction
+// Returns whether the code ends by jumping away, otherwise whatever follows it runs next
+bool writeTile(emitter * e, unsigned int index, char context){
+    Module * module = e->module;
+    Instruction * instruction = &module->code[index];
+    FILE * out = e->out;
+    char value [64];
+    char other [64];
+
+    switch (instruction->op){
+        case OP_ACTIVATE_RIGHT:
+            writeSpan(e, index + 1, instruction->rightEnd, 1, "    ");
+            break;
+        case OP_ACTIVATE_LEFT:
+            writeSpan(e, (int)index - 1, instruction->leftEnd, -1, "    ");
+            break;
+        case OP_POKE:
+        case OP_REMOTE:
+            writeSpan(e, instruction->target, instruction->target + 1, 1, "    ");
+            break;
+        case OP_DEACTIVATE_LEFT:
+            return writeDeactivation(e, index, instruction->leftEnd, -1, context);
+        case OP_DEACTIVATE_RIGHT:
+            return writeDeactivation(e, index, instruction->rightEnd, 1, context);
+        case OP_COMPARE:
+            if (instruction->loop != NULL && e->pendingLow == e->pendingHigh){
+                writeLoop(e, index, instruction);
+            }
+            // Comparing right to left and then activating in that direction, left when they are equal
+            operandValue(e, &instruction->right, value);
+            operandValue(e, &instruction->left, other);
+            fprintf(out, "    if (%s > %s){\n", value, other);
+            writeSpan(e, index + 1, instruction->rightEnd, 1, "        ");
+            fprintf(out, "    } else {\n");
+            writeSpan(e, (int)index - 1, instruction->leftEnd, -1, "        ");
+            fprintf(out, "    }\n");
+            break;
+        case OP_ASSIGN: {
+            char sum [2 * sizeof value + 40]; // Room for both operands and the casts around them
+            operandValue(e, &instruction->left, value);
+            operandValue(e, &instruction->right, other);
+            sprintf(sum, "(int)((unsigned int)%s + (unsigned int)%s)", value, other);
+            writeSet(e, instruction->point, sum, "    ");
+            break;
+        }
+        case OP_INCREMENT:
+        case OP_DECREMENT: {
+            int change = instruction->op == OP_INCREMENT ? 1 : -1;
+            Point * point = instruction->point;
+            if (point->slot != -1){
+                fprintf(out, "    slots[%d] = (int)((unsigned int)slots[%d] %c 1u);\n", point->slot, point->slot, change == 1 ? '+' : '-');
+            } else {
+                fprintf(out, "    tasChange(frame, &points%u[%u], %d);\n", e->index, e->pointIndex[point - module->points], change);
+            }
+            break;
+        }
+        case OP_INPUT:
+            writeSet(e, instruction->point, "tasReadInput()", "    ");
+            break;
+        case OP_PARAMETER:
+            // Using the next argument, or 0 when they have run out
+            fprintf(out, "    if (frame->argumentsUsed < frame->argumentCount){\n");
+            writeSet(e, instruction->point, "frame->arguments[frame->argumentsUsed]", "        ");
+            fprintf(out, "        frame->argumentsUsed++;\n");
+            fprintf(out, "    } else {\n");
+            fprintf(out, "        tasNoParameter();\n");
+            writeSet(e, instruction->point, "0", "        ");
+            fprintf(out, "    }\n");
+            break;
+        case OP_DESTROY:
+            if (instruction->point->slot != -1){
+                fprintf(out, "    slots[%d] = 0;\n", instruction->point->slot);
+            } else {
+                fprintf(out, "    tasRemove(frame, &points%u[%u]);\n", e->index, e->pointIndex[instruction->point - module->points]);
+            }
+            break;
+        case OP_CALL: {
+            Call * call = instruction->call;
+            int target = e->prog->targets[e->index][index];
+            if (target == -1){
+                fprintf(out, "    tasMissingFile(\"%s\");\n", call->fileName);
+                break;
+            }
+            // Pushing the called module's frame and jumping to its start, it jumps back to the label after this once it ends
+            // Each copy of a call's code has its own label, as a tile is written once for the queue and once for each span
+            unsigned int resume = e->prog->resumeCount;
+            e->prog->resumeCount++;
+            fprintf(out, "    {\n");
+            fprintf(out, "        tasFrame * callee = tasPushFrame(&pool%d, %u, %u);\n", target, call->argumentCount, call->returnHolderCount);
+            for (unsigned int i = 0; i < call->argumentCount; i++){
+                pointValue(e, call->arguments[i], value);
+                fprintf(out, "        callee->arguments[%u] = %s;\n", i, value);
+            }
+            fprintf(out, "        callee->resume = %u;\n", resume);
+            fprintf(out, "        frame = callee;\n");
+            fprintf(out, "    }\n");
+            fprintf(out, "    queue = &frame->queue;\n");
+            fprintf(out, "    slots = frame->slots;\n");
+            fprintf(out, "    goto start%d;\n", target);
+            fprintf(out, "resume%u:\n", resume);
+            for (unsigned int i = 0; i < call->returnHolderCount; i++){
+                sprintf(other, "tasReturned()->returns[%u]", i);
+                writeSet(e, call->returnHolders[i], other, "    ");
+            }
+            break;
+        }
+        case OP_OUTPUT_INT:
+            pointValue(e, instruction->point, value);
+            fprintf(out, "    printf(\"%%d\", %s);\n", value);
+            break;
+        case OP_RETURN:
+            // Setting the value of the next return holder
+            pointValue(e, instruction->point, value);
+            fprintf(out, "    if (frame->returnsUsed < frame->returnCount){\n");
+            fprintf(out, "        frame->returns[frame->returnsUsed] = %s;\n", value);
+            fprintf(out, "        frame->returnsUsed++;\n");
+            fprintf(out, "    }\n");
+            break;
+        case OP_OUTPUT_CHAR:
+            pointValue(e, instruction->point, value);
+            fprintf(out, "    putchar(%s);\n", value);
+            break;
+        case OP_NEWLINE:
+            fprintf(out, "    putchar('\\n');\n");
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+// Writes the tiles of every span that is run straight through in one direction
+// Each tile falls through into the next one of its span, and spans that start partway through another share its tiles
+void writeStraightSpans(emitter * e, int direction){
+    Module * module = e->module;
+    bool * starts = direction == 1 ? e->rightStarts : e->leftStarts;
+    char context = direction == 1 ? 'R' : 'L';
+    const char * label = direction == 1 ? "right" : "left";
+
+    // Finding every tile that is part of one of the spans, stopping where a span reaches tiles already found
+    bool * inSpan = calloc(module->length > 0 ? module->length : 1, sizeof(bool));
+    for (unsigned int i = 0; i < module->length; i++){
+        if (!starts[i]){
+            continue;
+        }
+        for (int j = (int)i; j != -1 && !inSpan[j]; j = spanNext(module, j, direction)){
+            inSpan[j] = true;
+        }
+    }
+
+    int first = direction == 1 ? 0 : (int)module->length - 1;
+    int end = first;
+    for (int i = first; i >= 0 && i < (int)module->length; i += direction){
+        if (!inSpan[i]){
+            continue;
+        }
+        if (starts[i]){
+            fprintf(e->out, "%s%u_%d:\n", label, e->index, i);
+        }
+        if ((end - i) * direction <= 0){
+            // The first tile of a span that isn't part of the span before it
+            end = spanEnd(module, i, direction);
+        }
+        e->pendingLow = direction == 1 ? i + 1 : end + 1;
+        e->pendingHigh = direction == 1 ? end : i;
+
+        bool ended = module->code[i].op != OP_NOP && writeTile(e, (unsigned int)i, context);
+        if (!ended && spanNext(module, i, direction) == -1){
+            fprintf(e->out, "    goto next%u;\n", e->index);
+        }
+    }
+    e->pendingLow = 0;
+    e->pendingHigh = 0;
+    free(inSpan);
+}
+
+// Whether a tile's code reads or sets a variable with a joiner, which goes through the module's table of points
+bool usesJoiners(emitter * e, unsigned int index){
+    Instruction * instruction = &e->module->code[index];
+    switch (instruction->op){
+        case OP_COMPARE:
+        case OP_ASSIGN:
+            if (instruction->left.kind == OPERAND_POINT || instruction->right.kind == OPERAND_POINT){
+                return true;
+            }
+            return instruction->op == OP_ASSIGN && instruction->point->slot == -1;
+        case OP_INCREMENT:
+        case OP_DECREMENT:
+        case OP_INPUT:
+        case OP_PARAMETER:
+        case OP_DESTROY:
+        case OP_OUTPUT_INT:
+        case OP_RETURN:
+        case OP_OUTPUT_CHAR:
+            return instruction->point->slot == -1;
+        case OP_CALL:
+            if (e->prog->targets[e->index][index] == -1){
+                return false;
+            }
+            for (unsigned int i = 0; i < instruction->call->argumentCount; i++){
+                if (instruction->call->arguments[i]->slot == -1){
+                    return true;
+                }
+            }
+            for (unsigned int i = 0; i < instruction->call->returnHolderCount; i++){
+                if (instruction->call->returnHolders[i]->slot == -1){
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Writes the tables a module's code uses, its frame pool, its joiner points and the maps of its counted loops
+// The joiner points are left out when no tile's code uses them, as tiles like * can name them without reading them
+void writeModuleData(emitter * e){
+    Module * module = e->module;
+    FILE * out = e->out;
+
+    fprintf(out, "static tasPool pool%u = {%u, %u, %u, NULL, 0, 0, 0};\n", e->index, module->length, module->slotCount, module->arrayCount);
+
+    bool joiners = false;
+    for (unsigned int i = 0; i < module->length && !joiners; i++){
+        joiners = usesJoiners(e, i);
+    }
+    unsigned int joinerCount = 0;
+    for (unsigned int i = 0; i < module->pointCount && joiners; i++){
+        Point * point = &module->points[i];
+        if (point->slot == -1){
+            fprintf(out, "static const int joins%u_%u [] = {", e->index, joinerCount);
+            for (unsigned int j = 0; j < point->joinCount; j++){
+                fprintf(out, j == 0 ? "%d" : ", %d", point->joinSlots[j]);
+            }
+            fprintf(out, "};\n");
+            e->pointIndex[i] = joinerCount;
+            joinerCount++;
+        }
+    }
+    if (joinerCount > 0){
+        fprintf(out, "static const tasPoint points%u [] = {\n", e->index);
+        for (unsigned int i = 0; i < module->pointCount; i++){
+            Point * point = &module->points[i];
+            if (point->slot == -1){
+                fprintf(out, "    {\"%.*s\", %u, %u, joins%u_%u, %d},\n", (int)point->baseLength, point->name,
+                        point->baseLength, point->joinCount, e->index, e->pointIndex[i], point->array);
+            }
+        }
+        fprintf(out, "};\n");
+    }
+
+    for (unsigned int i = 0; i < module->length; i++){
+        Loop * loop = module->code[i].loop;
+        if (loop == NULL || loop->counter == -1){
+            continue;
+        }
+        unsigned int width = loop->slotCount + 1;
+        fprintf(out, "static const unsigned int loopSlots%u_%u [] = {", e->index, i);
+        for (unsigned int j = 0; j < loop->slotCount; j++){
+            fprintf(out, j == 0 ? "%u" : ", %u", loop->slots[j]);
+        }
+        fprintf(out, "};\n");
+        fprintf(out, "static const unsigned int loopTransform%u_%u [] = {", e->index, i);
+        for (unsigned int j = 0; j < width * width; j++){
+            fprintf(out, j == 0 ? "%uu" : ", %uu", loop->transform[j]);
+        }
+        fprintf(out, "};\n");
+    }
+}
+
+// Gets ready to write a module, finding where its spans that are run straight through start
+void startEmitter(emitter * e, FILE * out, program * prog, unsigned int index){
+    Module * module = prog->modules[index];
+    unsigned int length = module->length > 0 ? module->length : 1;
+    *e = (emitter){out, prog, index, module, NULL, NULL, NULL, 0, 0};
+    e->pointIndex = calloc(module->pointCount > 0 ? module->pointCount : 1, sizeof(unsigned int));
+    e->rightStarts = calloc(length, sizeof(bool));
+    e->leftStarts = calloc(length, sizeof(bool));
+
+    for (unsigned int i = 0; i < module->length; i++){
+        Instruction * instruction = &module->code[i];
+        bool right = instruction->op == OP_ACTIVATE_RIGHT || instruction->op == OP_COMPARE;
+        bool left = instruction->op == OP_ACTIVATE_LEFT || instruction->op == OP_COMPARE;
+        if (right && isStraightSpan(i + 1, instruction->rightEnd)){
+            e->rightStarts[i + 1] = true;
+        }
+        if (left && isStraightSpan((int)i - 1, instruction->leftEnd)){
+            e->leftStarts[i - 1] = true;
+        }
+    }
+}
+
+void freeEmitter(emitter * e){
+    free(e->pointIndex);
+    free(e->rightStarts);
+    free(e->leftStarts);
+}
+
+// Writes the code that runs one module, which starts at its start label once its frame has been pushed
+void writeModule(emitter * e){
+    Module * module = e->module;
+    FILE * out = e->out;
+    unsigned int index = e->index;
+
+    fprintf(out, "\n    // %s\n", module->path);
+    fprintf(out, "start%u:\n", index);
+    for (unsigned int i = 0; i < module->initialCount; i++){
+        fprintf(out, "    tasActivate(queue, %u);\n", module->initial[i]);
+    }
+
+    // Taking the next tile off the queue, the call ends once it is empty
+    fprintf(out, "next%u:\n", index);
+    fprintf(out, "    if (queue->live == 0){\n");
+    fprintf(out, "        goto finished;\n");
+    fprintf(out, "    }\n");
+    fprintf(out, "    switch (tasNextActivation(queue)){\n");
+    for (unsigned int i = 0; i < module->length; i++){
+        if (module->code[i].op != OP_NOP){
+            fprintf(out, "        case %u: goto tile%u_%u;\n", i, index, i);
+        }
+    }
+    fprintf(out, "        default: goto next%u;\n", index);
+    fprintf(out, "    }\n");
+
+    for (unsigned int i = 0; i < module->length; i++){
+        if (module->code[i].op != OP_NOP){
+            fprintf(out, "tile%u_%u:\n", index, i);
+            if (!writeTile(e, i, 'D')){
+                fprintf(out, "    goto next%u;\n", index);
+            }
+        }
+    }
+    writeStraightSpans(e, 1);
+    writeStraightSpans(e, -1);
+}
+
+// Writes the C file for a program, returning whether it could be written
+// Every module is written into one function, so calls go on the frame stack rather than the C stack
+bool writeProgram(program * prog, const char * outputName, size_t memoryBudget){
+    FILE * out = fopen(outputName, "w");
+    if (out == NULL){
+        printf("Error - Could not write %s\n", outputName);
+        return false;
+    }
+
+    fprintf(out, "// Generated by tas2c from %s\n\n", prog->modules[0]->path);
+    fprintf(out, "#define TAS_MEMORY_BUDGET %zuu\n\n", memoryBudget);
+    fputs(runtimeSource, out);
+    emitter * emitters = malloc(sizeof(emitter) * prog->count);
+    for (unsigned int i = 0; i < prog->count; i++){
+        startEmitter(&emitters[i], out, prog, i);
+        fprintf(out, "\n// %s\n", prog->modules[i]->path);
+        writeModuleData(&emitters[i]);
+    }
+
+    fprintf(out, "\nstatic void tasRunProgram(void){\n");
+    fprintf(out, "    tasFrame * frame = tasPushFrame(&pool0, 0, 0);\n");
+    fprintf(out, "    tasQueue * queue = &frame->queue;\n");
+    fprintf(out, "    int * slots = frame->slots;\n");
+    fprintf(out, "    (void)slots; // Programs whose tiles never touch a variable don't read it\n");
+    fprintf(out, "    goto start0;\n");
+    prog->resumeCount = 0;
+    for (unsigned int i = 0; i < prog->count; i++){
+        writeModule(&emitters[i]);
+        freeEmitter(&emitters[i]);
+    }
+    free(emitters);
+
+    // Ending a call, and going back to the tile that made it
+    fprintf(out, "\nfinished:\n");
+    fprintf(out, "    tasPopFrame();\n");
+    if (prog->resumeCount == 0){
+        fprintf(out, "    return;\n");
+    } else {
+        fprintf(out, "    if (tasDepth == 0){\n");
+        fprintf(out, "        return;\n");
+        fprintf(out, "    }\n");
+        fprintf(out, "    frame = tasStack[tasDepth - 1];\n");
+        fprintf(out, "    queue = &frame->queue;\n");
+        fprintf(out, "    slots = frame->slots;\n");
+        fprintf(out, "    switch (tasReturned()->resume){\n");
+        for (unsigned int i = 0; i < prog->resumeCount; i++){
+            fprintf(out, "        case %u: goto resume%u;\n", i, i);
+        }
+        fprintf(out, "    }\n");
+    }
+    fprintf(out, "}\n");
+
+    // Running the program the way the interpreter does, with the same messages around its output
+    fprintf(out, "\nint main(void){\n");
+    fprintf(out, "    puts(\"Started\");\n");
+    fprintf(out, "    tasRunProgram();\n");
+    fprintf(out, "    printf(\"\\n\\nDone \\n\");\n");
+    fprintf(out, "    return 0;\n");
+    fprintf(out, "}\n");
+
+    bool written = !ferror(out);
+    fclose(out);
+    return written;
+}
+
+int main(int argc, char* argv[]){
+    char * fileName = NULL;
+    char * outputName = NULL;
+    size_t memoryBudget = DEFAULT_MEMORY_BUDGET;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            // Where the C file is written, the program's name with .c in place of .ptas by default
+            i++;
+            outputName = argv[i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+            // The memory budget for function calls in megabytes, as TAS -m
+            i++;
+            memoryBudget = (size_t)strtoull(argv[i], NULL, 10) * 1024 * 1024;
+        } else {
+            fileName = argv[i];
+        }
+    }
+    if (fileName == NULL){
+        puts("Need a file to translate");
+        return 1;
+    }
+    if (!moduleExists(fileName)){
+        printf("File %s does not exist\n", fileName);
+        return 1;
+    }
+
+    size_t length = strlen(fileName);
+    char defaultName [length + 3];
+    if (outputName == NULL){
+        strcpy(defaultName, fileName);
+        char * extension = strrchr(defaultName, '.');
+        if (extension != NULL && (strcmp(extension, ".ptas") == 0 || strcmp(extension, ".ptasb") == 0)){
+            *extension = '\0';
+        }
+        strcat(defaultName, ".c");
+        outputName = defaultName;
+    }
+
+    program prog = {NULL, NULL, NULL, 0, 0, tasCreateVarMgr(), 0};
+    findModule(&prog, fileName);
+    findCallTargets(&prog);
+    bool written = writeProgram(&prog, outputName, memoryBudget);
+    if (written){
+        printf("Wrote %s with %u modules\n", outputName, prog.count);
+    }
+
+    for (unsigned int i = 0; i < prog.count; i++){
+        if (prog.loaded[i]){
+            tasFreeModule(prog.modules[i]);
+        }
+        free(prog.targets[i]);
+    }
+    free(prog.modules);
+    free(prog.loaded);
+    free(prog.targets);
+    tasFreeVarMgr(prog.paths);
+    return written ? 0 : 1;
+}
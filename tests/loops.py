@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# Makes random counted loops of the kind loop acceleration looks for, and checks that running them natively
+# prints the same thing and counts the same cycles as running them tile by tile with -l
+# Loops that never stop are cut off by a cycle budget, which has to be hit on the same cycle both ways
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+
+# Pieces of a loop body, updates that make a closed form possible and some that only allow running natively
+BODY = ['+a', '-a', '+n', '-n', '-n', '-n-n', '*a*b=c', '*c=a*b', '*n=b*a', '*a=a*a', '|||=a*b', '*m-m', '+m', '*c=c*n',
+        '*b=b*c', '*m=m*a']
+LEFTS = ['*m', '||', '^z', '*n', '*a']
+RIGHTS = ['*n', '*n', '*m', '|||']
+BUDGET = '2000000'
+
+
+def makeProgram(generator):
+    body = ''.join(generator.choice(BODY) for _ in range(generator.randint(1, 6)))
+    return '.>"n"m,top_@a;@b;@c;@n;@m;' + generator.choice(LEFTS) + '?top' + generator.choice(RIGHTS) + body + ',top'
+
+
+# Drops the lines of -b output that change from run to run
+def cycleReport(output):
+    lines = output.decode(errors='replace').splitlines()
+    return [line for line in lines if not line.startswith('Time:') and not line.startswith('Cycles per second:')]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--tas', required=True)
+    parser.add_argument('--work', required=True)
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--count', type=int, default=200)
+    args = parser.parse_args()
+
+    os.makedirs(args.work, exist_ok=True)
+    generator = random.Random(args.seed)
+    failures = 0
+    for _ in range(args.count):
+        program = makeProgram(generator)
+        n = generator.choice([generator.randint(-5, 30), generator.randint(0, 200000)])
+        m = generator.randint(-5, 30)
+        stdin = ('%d\n%d\n' % (n, m)).encode()
+        with open(os.path.join(args.work, 'loop.ptas'), 'w') as file:
+            file.write(program)
+
+        reports = []
+        for flags in ([], ['-l']):
+            result = subprocess.run([args.tas, '-b', '-n', BUDGET] + flags + ['loop.ptas'], cwd=args.work, input=stdin,
+                                    capture_output=True, timeout=120)
+            reports.append(cycleReport(result.stdout))
+        if reports[0] != reports[1]:
+            failures += 1
+            print('FAIL %s with n=%d m=%d\n  natively: %r\n  -l: %r' % (program, n, m, reports[0], reports[1]))
+
+    print('%d loops, %d failures' % (args.count, failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Runs every program in programs/ that has a .in file and checks what it prints against its .out file
+# Each one is run with every optimisation on and off, from an image and a bundle, and translated to C with tas2c
+# Runs that should take the same number of cycles are also checked against each other
+
+import argparse
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PROGRAMS = os.path.join(HERE, 'programs')
+STDLIB = os.path.join(HERE, '..', 'cmake-build-debug', 'stdlib')
+
+# The flags each program is run with, they must all print the same thing
+VARIANTS = [[], ['-l'], ['-c'], ['-i'], ['-p'], ['-i', '-c'], ['-i', '-c', '-p'], ['-l', '-c', '-i', '-p']]
+
+# Flags that only change how long the run takes, not how many cycles it counts
+# Native versions and remembered calls skip cycles, so those are compared among themselves
+SAME_CYCLES = [[[], ['-l'], ['-p'], ['-l', '-p']],
+               [['-i', '-c'], ['-i', '-c', '-l'], ['-i', '-c', '-p'], ['-i', '-c', '-l', '-p']]]
+
+failures = []
+
+
+def fail(message):
+    failures.append(message)
+    print('FAIL ' + message)
+
+
+def run(command, folder, stdin):
+    result = subprocess.run(command, cwd=folder, input=stdin, capture_output=True, timeout=120)
+    return result.stdout
+
+
+# Copies the programs and the stdlib into a new folder and prepares them with PREPPER and any flags given
+def prepare(folder, prepper, flags):
+    shutil.rmtree(folder, ignore_errors=True)
+    os.makedirs(folder)
+    for source in glob.glob(os.path.join(PROGRAMS, '*.tas')):
+        shutil.copy(source, folder)
+    shutil.copytree(STDLIB, os.path.join(folder, 'stdlib'))
+    sources = sorted(os.path.basename(path) for path in glob.glob(os.path.join(folder, '*.tas')))
+    result = subprocess.run([prepper] + flags + sources, cwd=folder, capture_output=True)
+    if result.returncode != 0:
+        fail('PREPPER %s: %s' % (' '.join(flags), result.stdout.decode(errors='replace')))
+
+
+# Drops the lines of -b output that change from run to run
+def cycleReport(output):
+    lines = output.decode(errors='replace').splitlines()
+    return [line for line in lines if not line.startswith('Time:') and not line.startswith('Cycles per second:')]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--tas', required=True)
+    parser.add_argument('--prepper', required=True)
+    parser.add_argument('--tas2c', required=True)
+    parser.add_argument('--cc', required=True)
+    parser.add_argument('--work', required=True)
+    args = parser.parse_args()
+
+    entries = sorted(os.path.basename(path)[:-3] for path in glob.glob(os.path.join(PROGRAMS, '*.in')))
+    inputs = {}
+    expected = {}
+    for name in entries:
+        with open(os.path.join(PROGRAMS, name + '.in'), 'rb') as file:
+            inputs[name] = file.read()
+        with open(os.path.join(PROGRAMS, name + '.out'), 'rb') as file:
+            expected[name] = file.read()
+
+    text = os.path.join(args.work, 'text')
+    prepare(text, args.prepper, [])
+    for name in entries:
+        for flags in VARIANTS:
+            output = run([args.tas] + flags + [name + '.ptas'], text, inputs[name])
+            if output != expected[name]:
+                fail('%s with %s printed %r' % (name, ' '.join(flags) or 'no flags', output[:200]))
+        for group in SAME_CYCLES:
+            reports = [cycleReport(run([args.tas, '-b'] + flags + [name + '.ptas'], text, inputs[name])) for flags in group]
+            for flags, report in zip(group[1:], reports[1:]):
+                if report != reports[0]:
+                    fail('%s with %s counted %r, not %r' % (name, ' '.join(flags), report, reports[0]))
+
+    # Loaded from binary images and from bundles of every module a program calls
+    for kind, flags in (('images', ['-b']), ('bundles', ['-l'])):
+        folder = os.path.join(args.work, kind)
+        prepare(folder, args.prepper, flags)
+        for name in entries:
+            output = run([args.tas, name + '.ptas'], folder, inputs[name])
+            if output != expected[name]:
+                fail('%s from %s printed %r' % (name, kind, output[:200]))
+
+    # Translated to C, which has no flags of its own
+    for name in entries:
+        translated = subprocess.run([args.tas2c, name + '.ptas', '-o', name + '.c'], cwd=text, capture_output=True)
+        if translated.returncode != 0:
+            fail('tas2c %s: %s' % (name, translated.stdout.decode(errors='replace')))
+            continue
+        # The translation has to compile without warnings
+        compiled = subprocess.run([args.cc, '-O1', '-Wall', '-Wextra', '-Werror', '-o', name + '.bin', name + '.c'], cwd=text,
+                                  capture_output=True)
+        if compiled.returncode != 0:
+            fail('compiling %s.c: %s' % (name, compiled.stderr.decode(errors='replace')[:500]))
+            continue
+        output = run([os.path.join(text, name + '.bin')], text, inputs[name])
+        if output != expected[name]:
+            fail('%s translated to C printed %r' % (name, output[:200]))
+
+    print('%d programs, %d failures' % (len(entries), len(failures)))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
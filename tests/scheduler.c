@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "tas.h"
+#include "scheduler.h"
+
+// Runs many instances through the scheduler with tiny quanta and checks each one ends up where a plain tasRun would
+// Every run waits for its input, so it is parked and woken for each value, from the waiting thread or from another one
+// Then checks that the cycle and memory budgets still stop runs that never finish or grow without end, with and without
+// the scheduler
+// Run from a folder with the stdlib in it, the first program calls stdadd
+
+#define RUN_COUNT 32
+#define VALUE_COUNT 2
+
+// Reads x and y, adds them with stdadd, then counts i up to y in a loop that can be run natively
+const char addSource [] = ".> \"x \"y *x *y &stdadd *r @r ; ,top\n_ @i ; *i ?top *y +i ,top";
+// Never stops, the ? always activates the remote activator again
+const char spinSource [] = ".> \"n ,loop\n_ ?loop *n ,loop";
+// Sets a new joiner variable every time round, so its memory keeps growing
+const char growSource [] = ".> \"n ,top\n_ *i ?top *n +v:i +i ,top";
+
+// Values for one run that are handed out as they are fed in, until then the run waits
+typedef struct FeedStruct {
+    pthread_mutex_t lock;
+    int values [VALUE_COUNT];
+    int fed; // How many values can be read
+    int read; // How many have been read
+} feed;
+
+typedef struct RunStruct {
+    tasInstance * instance;
+    tasTask * task;
+    feed input;
+    int result;
+    bool finished;
+} run;
+
+pthread_mutex_t finishLock = PTHREAD_MUTEX_INITIALIZER;
+int finishedCount;
+int failures;
+
+int readFeed(void * context, int * value){
+    feed * input = (feed *)context;
+    pthread_mutex_lock(&input->lock);
+    int result = TAS_INPUT_WAIT;
+    if (input->read < input->fed){
+        *value = input->values[input->read];
+        input->read++;
+        result = TAS_INPUT_READ;
+    } else if (input->read == VALUE_COUNT){
+        result = TAS_INPUT_END;
+    }
+    pthread_mutex_unlock(&input->lock);
+    return result;
+}
+
+void feedValue(feed * input){
+    pthread_mutex_lock(&input->lock);
+    input->fed++;
+    pthread_mutex_unlock(&input->lock);
+}
+
+void finishRun(void * context, tasInstance * instance, int result){
+    (void)instance;
+    run * finished = (run *)context;
+    finished->result = result;
+    pthread_mutex_lock(&finishLock);
+    finished->finished = true;
+    finishedCount++;
+    pthread_mutex_unlock(&finishLock);
+}
+
+int countFinished(){
+    pthread_mutex_lock(&finishLock);
+    int count = finishedCount;
+    pthread_mutex_unlock(&finishLock);
+    return count;
+}
+
+void fail(const char * what, unsigned int threadCount, unsigned long long quantum){
+    printf("FAIL %s, with %u threads and a quantum of %llu\n", what, threadCount, quantum);
+    failures++;
+}
+
+typedef struct FeederStruct {
+    tasScheduler * scheduler;
+    run * runs;
+} feeder;
+
+// Feeds each run its values one at a time and wakes it, while other threads are taking turns
+void * feedRuns(void * argument){
+    feeder * work = (feeder *)argument;
+    for (int value = 0; value < VALUE_COUNT; value++){
+        for (int i = 0; i < RUN_COUNT; i++){
+            usleep(50);
+            feedValue(&work->runs[i].input);
+            tasWake(work->scheduler, work->runs[i].task);
+        }
+    }
+    return NULL;
+}
+
+// Runs every instance of the add program through a scheduler and checks what each one printed and how many cycles it took
+void checkParkedRuns(tasProgram * program, const tasOptions * options, unsigned int threadCount, unsigned long long quantum){
+    run runs [RUN_COUNT];
+    tasScheduler * scheduler = tasCreateScheduler(threadCount, quantum);
+    finishedCount = 0;
+    for (int i = 0; i < RUN_COUNT; i++){
+        pthread_mutex_init(&runs[i].input.lock, NULL);
+        runs[i].input.values[0] = i;
+        runs[i].input.values[1] = 100 + i * 7;
+        runs[i].input.fed = 0;
+        runs[i].input.read = 0;
+        runs[i].finished = false;
+        runs[i].instance = tasCreateInstance(program, options);
+        tasSetInput(runs[i].instance, readFeed, &runs[i].input);
+        tasSetOutput(runs[i].instance, NULL, NULL);
+        tasStart(runs[i].instance, NULL, 0, 0);
+        runs[i].task = tasSchedule(scheduler, runs[i].instance, finishRun, &runs[i]);
+    }
+
+    if (threadCount == 0){
+        // Every run parks at each " tile until all of them have been fed and woken
+        for (int value = 0; value < VALUE_COUNT; value++){
+            if (tasWaitScheduler(scheduler) != RUN_COUNT){
+                fail("not every run was parked waiting for input", threadCount, quantum);
+            }
+            for (int i = 0; i < RUN_COUNT; i++){
+                feedValue(&runs[i].input);
+                tasWake(scheduler, runs[i].task);
+            }
+        }
+        if (tasWaitScheduler(scheduler) != 0){
+            fail("runs were still parked after all of their input", threadCount, quantum);
+        }
+    } else {
+        // Runs can be woken while they are taking a turn, before they have parked
+        feeder work = {scheduler, runs};
+        pthread_t thread;
+        pthread_create(&thread, NULL, feedRuns, &work);
+        while (tasWaitScheduler(scheduler) > 0 || countFinished() < RUN_COUNT){
+            usleep(200);
+        }
+        pthread_join(thread, NULL);
+    }
+
+    for (int i = 0; i < RUN_COUNT; i++){
+        // The same run in one go, with its input given up front
+        tasInstance * reference = tasCreateInstance(program, options);
+        tasSetInputValues(reference, runs[i].input.values, VALUE_COUNT);
+        tasSetOutput(reference, NULL, NULL);
+        unsigned long long cycles;
+        int result = tasRun(reference, NULL, 0, NULL, 0, &cycles);
+
+        size_t length;
+        size_t expectedLength;
+        const char * output = tasGetOutput(runs[i].instance, &length);
+        const char * expected = tasGetOutput(reference, &expectedLength);
+        if (!runs[i].finished || runs[i].result != result || result != TAS_OK){
+            fail("a run didn't finish", threadCount, quantum);
+        } else if (length != expectedLength || memcmp(output, expected, length) != 0){
+            fail("a run printed something else", threadCount, quantum);
+        } else if (tasCycles(runs[i].instance) != cycles){
+            fail("a run took a different number of cycles", threadCount, quantum);
+        }
+        tasFreeInstance(reference);
+    }
+
+    tasFreeScheduler(scheduler);
+    for (int i = 0; i < RUN_COUNT; i++){
+        tasFreeInstance(runs[i].instance);
+        pthread_mutex_destroy(&runs[i].input.lock);
+    }
+}
+
+// Runs a program that reads one value through a scheduler, returning what it finished with
+int runBudgeted(const char * source, int value, const tasOptions * options, unsigned int threadCount, unsigned long long quantum,
+                unsigned long long * cycles){
+    int result;
+    tasProgram * program = tasLoadSource("budget", source, strlen(source), &result);
+    if (program == NULL){
+        return result;
+    }
+    tasInstance * instance = tasCreateInstance(program, options);
+    tasSetInputValues(instance, &value, 1);
+    tasSetOutput(instance, NULL, NULL);
+    tasScheduler * scheduler = tasCreateScheduler(threadCount, quantum);
+    run budgeted = {instance, NULL, {PTHREAD_MUTEX_INITIALIZER, {0}, 0, 0}, TAS_OK, false};
+    finishedCount = 0;
+    tasStart(instance, NULL, 0, 0);
+    budgeted.task = tasSchedule(scheduler, instance, finishRun, &budgeted);
+    tasWaitScheduler(scheduler);
+    tasFreeScheduler(scheduler);
+    *cycles = tasCycles(instance);
+    tasFreeInstance(instance);
+    tasFreeProgram(program);
+    return budgeted.finished ? budgeted.result : TAS_RUNNING;
+}
+
+void checkBudgets(unsigned int threadCount, unsigned long long quantum){
+    tasOptions options;
+    unsigned long long cycles;
+    for (int accelerate = 0; accelerate < 2; accelerate++){
+        tasDefaultOptions(&options);
+        options.cycleBudget = 1000;
+        options.accelerateLoops = accelerate;
+        if (runBudgeted(spinSource, 1, &options, threadCount, quantum, &cycles) != TAS_ERROR_CYCLES || cycles != 1000){
+            fail("a loop that never stops wasn't stopped at its cycle budget", threadCount, quantum);
+        }
+    }
+
+    tasDefaultOptions(&options);
+    options.memoryBudget = 1 << 16;
+    if (runBudgeted(growSource, 100000, &options, threadCount, quantum, &cycles) != TAS_ERROR_MEMORY){
+        fail("a run that keeps growing wasn't stopped at its memory budget", threadCount, quantum);
+    }
+}
+
+// A plain tasRun has no quanta to stop between, so a run that keeps growing has to be stopped as soon as it goes over
+void checkGrowingRun(){
+    int result;
+    tasProgram * program = tasLoadSource("grow", growSource, sizeof(growSource) - 1, &result);
+    tasOptions options;
+    tasDefaultOptions(&options);
+    options.memoryBudget = 1 << 20;
+    tasInstance * instance = tasCreateInstance(program, &options);
+    int value = 3000000;
+    tasSetInputValues(instance, &value, 1);
+    tasSetOutput(instance, NULL, NULL);
+    if (tasRun(instance, NULL, 0, NULL, 0, NULL) != TAS_ERROR_MEMORY){
+        puts("FAIL a run that keeps growing wasn't stopped at its memory budget by tasRun");
+        failures++;
+    }
+    tasFreeInstance(instance);
+    tasFreeProgram(program);
+}
+
+// A run that is still parked when the scheduler is freed is dropped without its finish function being called
+void checkDroppedRun(tasProgram * program){
+    run parked;
+    pthread_mutex_init(&parked.input.lock, NULL);
+    parked.input.fed = 0;
+    parked.input.read = 0;
+    parked.finished = false;
+    parked.instance = tasCreateInstance(program, NULL);
+    tasSetInput(parked.instance, readFeed, &parked.input);
+    tasSetOutput(parked.instance, NULL, NULL);
+    tasScheduler * scheduler = tasCreateScheduler(2, 5);
+    tasStart(parked.instance, NULL, 0, 0);
+    parked.task = tasSchedule(scheduler, parked.instance, finishRun, &parked);
+    if (tasWaitScheduler(scheduler) != 1){
+        fail("a run with no input wasn't parked", 2, 5);
+    }
+    tasFreeScheduler(scheduler);
+    if (parked.finished){
+        fail("a dropped run was finished", 2, 5);
+    }
+    tasFreeInstance(parked.instance);
+    pthread_mutex_destroy(&parked.input.lock);
+}
+
+int main(){
+    int result;
+    tasProgram * program = tasLoadSource("add", addSource, sizeof(addSource) - 1, &result);
+    if (program == NULL){
+        puts("FAIL the add program couldn't be loaded, stdlib must be in the current folder");
+        return 1;
+    }
+
+    unsigned int threadCounts [] = {0, 1, 4};
+    unsigned long long quanta [] = {1, 3, 50};
+    for (unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++){
+        for (unsigned int q = 0; q < sizeof(quanta) / sizeof(quanta[0]); q++){
+            tasOptions options;
+            tasDefaultOptions(&options);
+            checkParkedRuns(program, &options, threadCounts[t], quanta[q]);
+            // Running stdadd as TAS, so its calls go through frames and leaf calls that don't fit in a quantum
+            options.useIntrinsics = false;
+            checkParkedRuns(program, &options, threadCounts[t], quanta[q]);
+            checkBudgets(threadCounts[t], quanta[q]);
+        }
+    }
+    checkGrowingRun();
+    checkDroppedRun(program);
+    tasFreeProgram(program);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# Makes random programs that call a random function, and checks that tas2c's translation of each one prints
+# the same thing as TAS running it
+# Programs that don't finish within a cycle budget, or can't be linked, are left out
+
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+from multiprocessing import Pool
+
+TILES = ['>', '<', '}', '{', '(', ')', '_', '*a', '*b', '*c', '|', '||', '|||', '=a', '=b', '+a', '+b', '-a', '-b', '+c', '-c',
+         '@a', '@b', ';', '~a', '*arr:a', '+arr:b', '@arr:a', '=arr:c', '*arr:b:c', '+arr:b:c', '@arr:b:c', '*n', '-n', '?',
+         "'a", '^a', '&sub*a', '*r']
+SUB_TILES = ["'a", "'b", '*a', '*b', '=c', '^c', '+a', '-b', '?', '>', '<', '_', '*c', ';', '@a', '^a']
+LABELS = ['x', 'y', 'z']
+BUDGET = '1000000'
+LEFT_OUT = 'left out'
+
+
+def makeProgram(generator):
+    tokens = ['.>']
+    for _ in range(generator.randint(5, 40)):
+        kind = generator.random()
+        if kind < 0.08:
+            tokens.append(',' + generator.choice(LABELS))
+        elif kind < 0.16:
+            tokens.append(generator.choice(['?', '+', '*', '_', '-']) + generator.choice(LABELS))
+        elif kind < 0.2:
+            tokens.append('.' + generator.choice(['>', '<', '+a', '*a']))
+        else:
+            tokens.append(generator.choice(TILES))
+    # Every remote activator needs a tile to activate
+    for label in LABELS:
+        tokens.insert(generator.randint(1, len(tokens)), '?' + label)
+    sub = '.>' + ' '.join(generator.choice(SUB_TILES) for _ in range(generator.randint(2, 12)))
+    return ' '.join(tokens), sub
+
+
+# Returns None when the translation matches, LEFT_OUT when the program was left out, otherwise what went wrong
+def check(job):
+    tas, tas2c, cc, work, seed = job
+    program, sub = makeProgram(random.Random(seed))
+    folder = os.path.join(work, 'p%d' % seed)
+    os.makedirs(folder, exist_ok=True)
+    with open(os.path.join(folder, 'p.ptas'), 'w') as file:
+        file.write(program)
+    with open(os.path.join(folder, 'sub.ptas'), 'w') as file:
+        file.write(sub)
+    stdin = b'3\n'
+
+    expected = subprocess.run([tas, '-n', BUDGET, 'p.ptas'], cwd=folder, input=stdin, capture_output=True, timeout=120).stdout
+    if b'budget of' in expected or b'could not be linked' in expected:
+        shutil.rmtree(folder)
+        return LEFT_OUT
+    translated = subprocess.run([tas2c, 'p.ptas', '-o', 'p.c'], cwd=folder, capture_output=True)
+    if translated.returncode != 0:
+        return 'tas2c failed on %r calling %r' % (program, sub)
+    # The translation has to compile without warnings
+    compiled = subprocess.run([cc, '-O1', '-Wall', '-Wextra', '-Werror', '-o', 'p', 'p.c'], cwd=folder, capture_output=True)
+    if compiled.returncode != 0:
+        return 'p.c from %r calling %r does not compile: %s' % (program, sub, compiled.stderr.decode(errors='replace')[:300])
+    try:
+        output = subprocess.run([os.path.join(folder, 'p')], cwd=folder, input=stdin, capture_output=True, timeout=60).stdout
+    except subprocess.TimeoutExpired:
+        return 'the translation of %r calling %r never finished' % (program, sub)
+    if output != expected:
+        return '%r calling %r printed %r, not %r' % (program, sub, output[:200], expected[:200])
+    shutil.rmtree(folder)
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--tas', required=True)
+    parser.add_argument('--tas2c', required=True)
+    parser.add_argument('--cc', required=True)
+    parser.add_argument('--work', required=True)
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--count', type=int, default=300)
+    args = parser.parse_args()
+
+    os.makedirs(args.work, exist_ok=True)
+    jobs = [(args.tas, args.tas2c, args.cc, args.work, seed) for seed in range(args.seed, args.seed + args.count)]
+    failures = 0
+    leftOut = 0
+    with Pool(os.cpu_count()) as pool:
+        for problem in pool.imap_unordered(check, jobs):
+            if problem == LEFT_OUT:
+                leftOut += 1
+            elif problem is not None:
+                failures += 1
+                print('FAIL ' + problem)
+
+    print('%d programs, %d left out, %d failures' % (args.count, leftOut, failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -3,93 +3,144 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-
-
-int varHash(const char *name, int size){
-    int hash = 0;
-    int i;
-    for (i = 0; i < strlen(name); i++){
-        hash = (hash * 31 + name[i]) % size;
+#define INITIAL_SIZE 16
+
+// FNV-1a hash of the name, also working out its length so it only has to be walked once
+static unsigned int varHash(const char *name, unsigned int *length){
+    unsigned int hash = 2166136261u;
+    const char *c;
+    for (c = name; *c != '\0'; c++){
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
     }
+    *length = c - name;
     return hash;
 }
 
 // Returns the index of a variable in the variable manager with the given name
-// If it does not exist, it will return the index of an empty slot
-// If the array is full, it will return -1
-int findVar(char *name, struct varmgr *inVarMgr){
-    int hash = varHash(name, inVarMgr->size);
-    int i;
-    for (i = 0; i < inVarMgr->size; i++) {
-        // If the name is null, or the name is the same as the one we are looking for
-        if ((inVarMgr->vars[hash].name == NULL) || (strcmp(inVarMgr->vars[hash].name, name) == 0)) {
-            return hash;
+// If it does not exist, it will return the index of the slot it should be inserted into,
+// which is the first removed slot passed on the way or else the empty slot that ended the probe
+// found is set to whether the variable exists
+static int findVar(const char *name, unsigned int hash, unsigned int length, struct varmgr *inVarMgr, bool *found){
+    unsigned int mask = inVarMgr->size - 1;
+    unsigned int index = hash & mask;
+    int firstRemoved = -1;
+    unsigned int probes = 1;
+
+    while (inVarMgr->vars[index].state != VAR_EMPTY){
+        var *slot = &inVarMgr->vars[index];
+        if (slot->state == VAR_USED){
+            if (slot->hash == hash && slot->length == length && memcmp(inVarMgr->names + slot->name, name, length) == 0){
+                break;
+            }
+        } else if (firstRemoved == -1){
+            firstRemoved = (int)index;
+        }
+        index = (index + 1) & mask; // Linear probing
+        probes++;
+    }
+
+    inVarMgr->lookups++;
+    inVarMgr->probes += probes;
+    if (probes > inVarMgr->longestProbe){
+        inVarMgr->longestProbe = probes;
+    }
+
+    *found = inVarMgr->vars[index].state == VAR_USED;
+    if (!*found && firstRemoved != -1){
+        return firstRemoved;
+    }
+    return (int)index;
+}
+
+// Copies a name onto the end of the name arena and returns where it starts
+static unsigned int storeName(const char *name, unsigned int length, struct varmgr *inVarMgr){
+    if (inVarMgr->namesLength + length > inVarMgr->namesCapacity){
+        while (inVarMgr->namesLength + length > inVarMgr->namesCapacity){
+            inVarMgr->namesCapacity *= 2;
         }
-        hash = (hash + 1) % inVarMgr->size; // Linear probing
+        inVarMgr->names = realloc(inVarMgr->names, inVarMgr->namesCapacity);
     }
-    return -1; // Array is full
+    unsigned int start = inVarMgr->namesLength;
+    memcpy(inVarMgr->names + start, name, length);
+    inVarMgr->namesLength += length;
+    return start;
 }
 
-// Doubles the size of the array and rehashes the variables
-// This is called when the array is full
-void expandArray(struct varmgr *inVarMgr){
-    int oldSize = inVarMgr->size;
-    inVarMgr->size *= 2;
+// Rebuilds the array with newSize slots, dropping removed slots
+// The name arena is rebuilt too so the names of removed variables don't pile up
+static void rehashVars(struct varmgr *inVarMgr, int newSize){
     var *oldVars = inVarMgr->vars;
-    inVarMgr->vars = malloc(sizeof(var) * inVarMgr->size);
+    int oldSize = inVarMgr->size;
+    char *oldNames = inVarMgr->names;
+
+    inVarMgr->size = newSize;
+    inVarMgr->vars = calloc(newSize, sizeof(var));
+    inVarMgr->names = malloc(inVarMgr->namesCapacity);
+    inVarMgr->namesLength = 0;
+    inVarMgr->removedCount = 0;
+
+    unsigned int mask = newSize - 1;
     int i;
-    for (i = 0; i < inVarMgr->size; i++){
-        inVarMgr->vars[i].name = NULL;
-        inVarMgr->vars[i].value = 0;
-    }
     for (i = 0; i < oldSize; i++){
-        // Rehashing the nonnull variables in the old array
-        if (oldVars[i].name != NULL){
-            int hash = varHash(oldVars[i].name, inVarMgr->size);
-            while (inVarMgr->vars[hash].name != NULL){
-                hash = (hash + 1) % inVarMgr->size; // Linear probing
+        // Reinserting the used slots, the stored hash means names don't need hashing again
+        if (oldVars[i].state == VAR_USED){
+            unsigned int index = oldVars[i].hash & mask;
+            while (inVarMgr->vars[index].state != VAR_EMPTY){
+                index = (index + 1) & mask; // Linear probing
             }
-            inVarMgr->vars[hash] = oldVars[i];
+            inVarMgr->vars[index] = oldVars[i];
+            inVarMgr->vars[index].name = storeName(oldNames + oldVars[i].name, oldVars[i].length, inVarMgr);
         }
-
     }
-    free(oldVars); // Free the old array
+    free(oldVars);
+    free(oldNames);
 }
 
-void insertVariable(char *name, struct varmgr *inVarMgr, int index){
-    // Checking if a name needs to be found.
-    if (index == -1){ // Index of -1 means that a name has not already been provided
-        // Finding an open name
-        index = findVar(name, inVarMgr); // Find the variable in the array or an empty slot
-        if (index == -1){ // If the array is full, then expand it and try again
-            expandArray(inVarMgr);
-            index = findVar(name, inVarMgr);
+// Returns the index of the variable with the given name, adding it with a value of 0 if it does not exist
+static int insertVariable(const char *name, struct varmgr *inVarMgr){
+    unsigned int length;
+    unsigned int hash = varHash(name, &length);
+    bool found;
+    int index = findVar(name, hash, length, inVarMgr, &found);
+    if (found){
+        return index;
+    }
+
+    // Keeping the array at most 70% full, counting removed slots since they lengthen probes too
+    // If most of that is removed slots, rehashing at the same size is enough
+    if ((inVarMgr->varCount + inVarMgr->removedCount + 1) * 10 > inVarMgr->size * 7){
+        int newSize = inVarMgr->size;
+        if ((inVarMgr->varCount + 1) * 10 > newSize * 7 / 2){
+            newSize *= 2;
         }
+        rehashVars(inVarMgr, newSize);
+        index = findVar(name, hash, length, inVarMgr, &found);
     }
-    int nameLength = strlen(name);
-    // Double-checking that the index points to a free name, then add a new variable with this name and a value of 0
-    if (inVarMgr->vars[index].name == NULL){ // If the name is null, then the variable does not exist
-        inVarMgr->vars[index].name = malloc(sizeof(char) * (nameLength + 1)); // Allocating space for the name
-        strncpy(inVarMgr->vars[index].name, name, nameLength); // Copying the name into the variable
-        inVarMgr->vars[index].name[nameLength] = '\0'; // Adding the null terminator
-        inVarMgr->vars[index].value = 0; // Setting the value to 0
-        inVarMgr->varCount++; // Incrementing the number of variables
+
+    var *slot = &inVarMgr->vars[index];
+    if (slot->state == VAR_REMOVED){
+        inVarMgr->removedCount--;
     }
+    slot->hash = hash;
+    slot->length = length;
+    slot->name = storeName(name, length, inVarMgr);
+    slot->value = 0;
+    slot->state = VAR_USED;
+    inVarMgr->varCount++; // Incrementing the number of variables
+    return index;
 }
 
 // Returns the value of a variable in the variable manager with the given name
 // Will return 0 if the variable does not exist
-// Will not ever create a new variable, use changeVar for that
-int getVar(char *inName, struct varmgr *inVarMgr){
-    char *name = joinName(inName, inVarMgr);
-
-    int index = findVar(name, inVarMgr); // Find the variable in the array or an empty slot
-
-    if (index == -1){ // If the array is full, then expand it and try again
-        return 0;
-    }
-
-    if (inVarMgr->vars[index].name == NULL){ // If the name is null, then the variable does not exist
+// Will not ever create a new variable, use tasChangeVar for that
+int tasGetVar(char *name, struct varmgr *inVarMgr){
+    unsigned int length;
+    unsigned int hash = varHash(name, &length);
+    bool found;
+    int index = findVar(name, hash, length, inVarMgr, &found);
+
+    if (!found){ // The variable does not exist
         return 0;
     }
 
@@ -99,19 +150,8 @@ int getVar(char *inName, struct varmgr *inVarMgr){
 
 // Changes the value of a variable in the variable manager with the given name
 // Will create a new variable if it does not exist
-void changeVar(char *inName, bool direction, struct varmgr *inVarMgr){
-    char *name = joinName(inName, inVarMgr);
-    int index = findVar(name, inVarMgr); // Find the variable in the array or an empty slot
-
-    if (index == -1){ // If the array is full, then expand it and try again
-        expandArray(inVarMgr);
-        index = findVar(name, inVarMgr);
-    }
-
-    // If the index points to a free name, then add a new variable with this name and a value of 0
-    if (inVarMgr->vars[index].name == NULL){ // If the name is null, then the variable does not exist
-        insertVariable(name, inVarMgr, index);
-    }
+void tasChangeVar(char *name, bool direction, struct varmgr *inVarMgr){
+    int index = insertVariable(name, inVarMgr);
 
     // Incrementing or decrementing the value at that index
     if (direction){
@@ -123,133 +163,101 @@ void changeVar(char *inName, bool direction, struct varmgr *inVarMgr){
 
 // Used to initialize a variable manager
 // Returns a pointer to the variable manager
-struct varmgr *createVarMgr(){
+struct varmgr *tasCreateVarMgr(){
     struct varmgr *newVarMgr = malloc(sizeof(struct varmgr));
-    newVarMgr->size = 1;
+    newVarMgr->size = INITIAL_SIZE;
     newVarMgr->varCount = 0;
-    newVarMgr->vars = malloc(sizeof(var) * newVarMgr->size);
-    int i;
-    for (i = 0; i < newVarMgr->size; i++){
-        newVarMgr->vars[i].name = NULL;
-        newVarMgr->vars[i].value = 0;
-    }
+    newVarMgr->removedCount = 0;
+    newVarMgr->vars = calloc(newVarMgr->size, sizeof(var));
+    newVarMgr->namesCapacity = INITIAL_SIZE * 8;
+    newVarMgr->namesLength = 0;
+    newVarMgr->names = malloc(newVarMgr->namesCapacity);
+    newVarMgr->lookups = 0;
+    newVarMgr->probes = 0;
+    newVarMgr->longestProbe = 0;
     return newVarMgr;
 }
 
 // Shows the variables in the variable manager
 // Used for debugging
-void showVars(struct varmgr *inVarMgr){
+void tasShowVars(struct varmgr *inVarMgr){
     // Printing a header
     printf("%3s %10s %5s\n", "loc", "Name", "Value");
     int i;
     for (i = 0; i < inVarMgr->size; i++){
-        if (inVarMgr->vars[i].name != NULL){
-            printf("%3d %10s %5d\n", i, inVarMgr->vars[i].name, inVarMgr->vars[i].value);
+        if (inVarMgr->vars[i].state == VAR_USED){
+            printf("%3d %10.*s %5d\n", i, (int)inVarMgr->vars[i].length, inVarMgr->names + inVarMgr->vars[i].name, inVarMgr->vars[i].value);
         } else {
-            printf("%3d %10s\n", i, "[]");
+            printf("%3d %10s\n", i, inVarMgr->vars[i].state == VAR_REMOVED ? "[removed]" : "[]");
         }
     }
 }
 
-// Frees the memory used by the variable manager
-void freeVarMgr(struct varmgr *inVarMgr){
-    int i;
-    for (i = 0; i < inVarMgr->size; i++){
-        if (inVarMgr->vars[i].name != NULL){
-            free(inVarMgr->vars[i].name); // Freeing the name
-        }
-    }
-    free(inVarMgr->vars); // Freeing the array
-    free(inVarMgr); // Freeing the variable manager
+// Shows how full the variable manager is and how long its probes are
+void tasShowVarStats(struct varmgr *inVarMgr){
+    printf("Variables: %d in %d slots (%.1f%% full, %d removed)\n",
+           inVarMgr->varCount,
+           inVarMgr->size,
+           100.0 * inVarMgr->varCount / inVarMgr->size,
+           inVarMgr->removedCount);
+    printf("Lookups: %llu, average probe length %.2f, longest probe %u\n",
+           inVarMgr->lookups,
+           inVarMgr->lookups > 0 ? (double)inVarMgr->probes / inVarMgr->lookups : 0.0,
+           inVarMgr->longestProbe);
 }
 
-char * joinName(char *name, struct varmgr *inVarMgr){
-    // Searching for a colon
-    // The value of the name between the colon and the next colon or the end is added to the name
-    // Then the value of the name that comes after the colon is added to the name
-
-    char * newName = malloc(sizeof(char) * (strlen(name) + 1));
-    newName[0] = '\0'; // Adding the null terminator
-
-    int i;
-    for (i = 0; i < strlen(name); i++){
-        if (name[i] == ':'){
-            // Adding the colon to the processed name
-            char tempC[2];
-            tempC[0] = ':';
-            tempC[1] = '\0';
-            strcat(newName, tempC);
-
-            // Using a for loop to find where this name ends
-            int j;
-            for(j = i + 1; j < strlen(name) && name[j] != ':'; j++){}
-
-            // Getting the value of the name between the colons
-            char tempName[j - i];
-            strncpy(tempName, name + i + 1, j - i - 1);
-
-            // Adding the null terminator
-            tempName[j - i - 1] = '\0';
-
-            // Using tempName to get the value of the variable in the variable manager
-            int value = getVar(tempName, inVarMgr);
-
-            // Converting the integer to a string using sprintf
-            char temp[10];
-            sprintf(temp, "%d", value);
-
-            // Adding the value to the processed name
-            strcat(newName, temp);
-
-            // Setting i to the end of the name
-            i = j - 1;
-
-
-        } else {
-            // Adding the character to the processed name, it's not special
-            char temp[2];
-            temp[0] = name[i];
-            temp[1] = '\0';
-            strcat(newName, temp);
-        }
+// Removes every variable from the variable manager
+// A table that grew is shrunk back to the size it started at, so clearing costs no more than the variables it held
+// and the memory it took up is given back, rather than clearing the largest size it ever reached on every reuse
+void tasClearVarMgr(struct varmgr *inVarMgr){
+    if (inVarMgr->varCount == 0 && inVarMgr->removedCount == 0){
+        // Nothing was added since it was last cleared, so every slot is already empty
+        return;
     }
-    return newName;
-
+    if (inVarMgr->size > INITIAL_SIZE){
+        free(inVarMgr->vars);
+        inVarMgr->size = INITIAL_SIZE;
+        inVarMgr->vars = calloc(inVarMgr->size, sizeof(var));
+    } else {
+        memset(inVarMgr->vars, 0, sizeof(var) * inVarMgr->size);
+    }
+    if (inVarMgr->namesCapacity > INITIAL_SIZE * 8){
+        free(inVarMgr->names);
+        inVarMgr->namesCapacity = INITIAL_SIZE * 8;
+        inVarMgr->names = malloc(inVarMgr->namesCapacity);
+    }
+    inVarMgr->varCount = 0;
+    inVarMgr->removedCount = 0;
+    inVarMgr->namesLength = 0;
 }
 
-void removeVar(char *inName, struct varmgr *inVarMgr){
-    char *name = joinName(inName, inVarMgr);
-    int index = findVar(name, inVarMgr); // Find the variable in the array or an empty slot
+// Frees the memory used by the variable manager
+void tasFreeVarMgr(struct varmgr *inVarMgr){
+    free(inVarMgr->vars); // Freeing the array
+    free(inVarMgr->names); // Freeing the names
+    free(inVarMgr); // Freeing the variable manager
+}
 
-    if (index == -1){ // Array is full and the variable does not exist
-        return;
-    }
+// Marks the slot as removed rather than emptying it, so probes for names after it still find them
+void tasRemoveVar(char *name, struct varmgr *inVarMgr){
+    unsigned int length;
+    unsigned int hash = varHash(name, &length);
+    bool found;
+    int index = findVar(name, hash, length, inVarMgr, &found);
 
-    if (inVarMgr->vars[index].name == NULL){ // If the name is null, then the variable does not exist
+    if (!found){ // The variable does not exist
         return;
     }
 
-    free(inVarMgr->vars[index].name);
-    inVarMgr->vars[index].name = NULL;
+    inVarMgr->vars[index].state = VAR_REMOVED;
     inVarMgr->vars[index].value = 0;
     inVarMgr->varCount--;
+    inVarMgr->removedCount++;
 }
 
 // Will create a new variable if it does not exist and set it to the value passed in
 // If the variable already exists, then it will set the value to the value passed in
-void setVar(char *inName, int value, struct varmgr *inVarMgr){
-    char *name = joinName(inName, inVarMgr);
-    int index = findVar(name, inVarMgr); // Find the variable in the array or an empty slot
-
-    if (index == -1){ // If the array is full, then expand it and try again
-        expandArray(inVarMgr);
-        index = findVar(name, inVarMgr);
-    }
-
-    // If the index points to a free name, then add a new variable with this name and a value of 0
-    if (inVarMgr->vars[index].name == NULL){ // If the name is null, then the variable does not exist
-        insertVariable(name, inVarMgr, index); // Inserting the variable
-    }
-
+void tasSetVar(char *name, int value, struct varmgr *inVarMgr){
+    int index = insertVariable(name, inVarMgr); // Find the variable in the array or add it
     inVarMgr->vars[index].value = value; // Setting the value
-}
\ No newline at end of file
+}
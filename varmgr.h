@@ -4,35 +4,59 @@
 
 #include <stdbool.h>
 
+// The states a slot in the variable array can be in
+#define VAR_EMPTY 0 // Never used, ends a probe
+#define VAR_USED 1 // Holds a variable
+#define VAR_REMOVED 2 // Held a variable that was removed, probes carry on past it
+
 typedef struct var_struct {
-    char *name;
+    unsigned int hash; // The full hash of the name, so probing only compares names when the hashes match
+    unsigned int name; // Where the name starts in the name arena
+    unsigned int length; // The length of the name
     int value;
+    char state; // VAR_EMPTY, VAR_USED or VAR_REMOVED
 } var;
 
 struct varmgr{
-    int size; // The size of the array
+    int size; // The size of the array, always a power of 2
     int varCount; // The number of variables in the array
+    int removedCount; // The number of removed slots in the array
     var* vars; // The array of variables
+
+    char *names; // Every name one after another, slots point into this
+    unsigned int namesLength; // How much of the name arena is used
+    unsigned int namesCapacity; // The size of the name arena
+
+    // Counters for seeing how well the table is doing
+    unsigned long long lookups; // How many times a name has been looked up
+    unsigned long long probes; // How many slots have been looked at over all lookups
+    unsigned int longestProbe; // The most slots looked at in one lookup
 };
 
+// The variable manager only works on fully resolved names, joiner (:) names
+// must already have their index values substituted in by the caller
+
 // Returns the value of a variable in the variable manager with the given name
 // Will return 0 if the variable does not exist
-int getVar(char *name, struct varmgr *inVarMgr);
+int tasGetVar(char *name, struct varmgr *inVarMgr);
 
 // Removes a variable from the variable manager with the given name
-void removeVar(char *name, struct varmgr *inVarMgr);
+void tasRemoveVar(char *name, struct varmgr *inVarMgr);
 
 // Increments or decrements the value of a variable by 1
-void changeVar(char *name, bool direction, struct varmgr *inVarMgr);
+void tasChangeVar(char *name, bool direction, struct varmgr *inVarMgr);
+
+void tasSetVar(char *name, int value, struct varmgr *inVarMgr);
 
-void setVar(char *name, int value, struct varmgr *inVarMgr);
+void tasClearVarMgr(struct varmgr *inVarMgr);
 
-void freeVarMgr(struct varmgr *inVarMgr);
+void tasFreeVarMgr(struct varmgr *inVarMgr);
 
-struct varmgr * createVarMgr();
+struct varmgr * tasCreateVarMgr();
 
-void showVars(struct varmgr *inVarMgr);
+void tasShowVars(struct varmgr *inVarMgr);
 
-char * joinName(char *name, struct varmgr *inVarMgr);
+// Shows how full the variable manager is and how long its probes are
+void tasShowVarStats(struct varmgr *inVarMgr);
 
 #endif //TAS_VARMGR_H